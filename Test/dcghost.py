@@ -0,0 +1,75 @@
+#
+# Host build of the firmware for the tests, no hardware needed.
+#
+# Compiles dcg.c, dcg-hw.c, dcg-panel.c, dcg-parser.c and timer.c with gcc together with Test/host
+# (replacement of avr-libc, the Common libraries and the hardware) into a shared library and loads it.
+# The variants are the build options of the firmware, e.g. load("DUAL_DAC") or load().
+#
+import ctypes
+import os
+import subprocess
+import tempfile
+
+TEST_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO_DIR = os.path.dirname(TEST_DIR)
+HOST_DIR = os.path.join(TEST_DIR, "host")
+SOURCES = ["dcg.c", "dcg-hw.c", "dcg-panel.c", "dcg-parser.c", "timer.c"]
+
+NoErr, ParamErr, LockedErr, BusyErr = 0, 1, 2, 3
+
+
+class Dcg(object):
+    def __init__(self, lib):
+        self.lib = lib
+        lib.host_set.restype = ctypes.c_uint8
+        lib.host_set.argtypes = [ctypes.c_uint8, ctypes.c_float]
+        lib.host_run_ms.argtypes = [ctypes.c_uint32]
+        lib.CalcArbSlope.restype = ctypes.c_uint32
+        lib.CalcArbSlope.argtypes = [ctypes.c_uint16, ctypes.c_uint16, ctypes.c_uint32]
+        lib.ArbTimeEncode.restype = ctypes.c_uint16
+        lib.ArbTimeEncode.argtypes = [ctypes.c_uint16, ctypes.c_uint8]
+        for f in ("GetVoltage", "GetCurrent", "GetPower"):
+            getattr(lib, f).restype = ctypes.c_float
+        lib.host_init()
+
+    def var(self, ctype, name):
+        return ctype.in_dll(self.lib, name)
+
+    def array(self, ctype, name, n):
+        return (ctype * n).in_dll(self.lib, name)
+
+    def set(self, subch, value):
+        # like "<subch>=<value>" from the bus, returns the prompt of the parser
+        return self.lib.host_set(subch, value)
+
+    def run_ms(self, ms):
+        self.lib.host_run_ms(ms)
+
+    def slot(self):
+        self.lib.host_slot()
+
+    @property
+    def dac_u(self):
+        return self.var(ctypes.c_uint16, "host_dac_u").value
+
+    @property
+    def dac_i(self):
+        return self.var(ctypes.c_uint16, "host_dac_i").value
+
+    def adc(self, u, i):
+        self.var(ctypes.c_uint16, "host_adc_u").value = u
+        self.var(ctypes.c_uint16, "host_adc_i").value = i
+
+
+def load(*defines):
+    # every load gets its own copy of the library, so the static variables start from scratch
+    out = tempfile.mkdtemp(prefix="dcghost")
+    so = os.path.join(out, "dcghost.so")
+    # -Wno-format: the firmware formats for avr-libc (%S for flash strings, long = int32_t)
+    cmd = ["gcc", "-shared", "-fPIC", "-O1", "-std=gnu99", "-funsigned-char", "-Wall", "-Wno-format", "-o", so,
+           "-I" + HOST_DIR, "-I" + os.path.join(REPO_DIR, "Config"), "-I" + REPO_DIR,
+           "-D__AVR_ATmega644P__", "-DF_CPU=16000000UL", "-Dmain=dcg_main"]
+    cmd += ["-D" + d for d in defines]
+    cmd += [os.path.join(HOST_DIR, "host.c")] + [os.path.join(REPO_DIR, s) for s in SOURCES] + ["-lm"]
+    subprocess.check_call(cmd)
+    return Dcg(ctypes.CDLL(so))
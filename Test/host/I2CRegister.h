@@ -0,0 +1,5 @@
+#pragma once
+#include <stdint.h>
+void I2C_Init(void);
+uint8_t I2CRegister_Write(uint8_t,uint8_t,uint8_t,uint8_t*);
+uint8_t I2CRegister_Read(uint8_t,uint8_t,uint8_t,uint8_t*);
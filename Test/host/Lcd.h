@@ -0,0 +1,19 @@
+#pragma once
+#include <stdint.h>
+uint8_t Lcd_Init(void);
+void Lcd_Write_P(uint8_t,uint8_t,uint8_t,const char*);
+void Lcd_Write(uint8_t,uint8_t,uint8_t,const char*);
+uint8_t Lcd_GetButton(void);
+#define BUTTON_DOWN 1
+#define BUTTON_UP 2
+#define BUTTON_ENTER 4
+#define SMALL_R_LOW 1
+#define SMALL_R_HIGH 2
+#define SMALL_A_INV 3
+#define SMALL_A 4
+#define BLOCK_HATCHED 5
+#define BLOCK_SOLID 6
+#define CURSOR_HATCHED 7
+#define CURSOR_SOLID 8
+#define CURSOR_CONCAVE 9
+void Lcd_OverWrite_P(uint8_t,uint8_t,uint8_t,const char*);
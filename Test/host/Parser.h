@@ -0,0 +1,9 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+enum { NoErr, ParamErr, LockedErr, BusyErr, OvlErr, FaultErr, FuseErr, ChkSumErr, SyntaxErr, OvflErr };
+void SerPrompt(uint8_t, uint8_t);
+void ParseGetParam(uint8_t);
+void ParseSetParam(uint8_t, float);
+void jobParseData(void);
+extern char g_cSerInpStr[];
@@ -0,0 +1,9 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#define INIT_UBRR 25
+uint8_t Uart_SetTxData(uint8_t*, uint8_t, uint8_t);
+uint8_t Uart_GetRxData(uint8_t*, uint8_t, uint8_t);
+void Uart_InitUBRR(uint8_t);
+#define _FDEV_SETUP_WRITE 2
+#define FDEV_SETUP_STREAM(p,g,f) {0}
@@ -0,0 +1,5 @@
+#pragma once
+#define ISR(v, ...) void v(void); void v(void)
+#define ISR_NOBLOCK
+#define cli()
+#define sei()
@@ -0,0 +1,107 @@
+#pragma once
+#include <stdint.h>
+#if defined(__AVR_ATmega32__)
+#define RAMEND 0x085F
+#elif defined(__AVR_ATmega324P__)
+#define RAMEND 0x08FF
+#elif defined(__AVR_ATmega1284P__)
+#define RAMEND 0x40FF
+#else
+#define RAMEND 0x10FF
+#endif
+extern volatile uint8_t PORTA,PORTB,PORTC,PORTD,PINA,PINB,PINC,PIND,DDRA,DDRB,DDRC,DDRD,SREG;
+extern volatile uint8_t OCR0A,OCR0B,TCNT0,TCCR0A,TCCR0B,TIMSK0,OCR2A,OCR2B,TCNT2,TCCR2A,TCCR2B,TIMSK2,TIFR2,TIFR0,ADMUX,ADCSRA,GTCCR,ASSR;
+extern volatile uint8_t TCCR1A,TCCR1B,TCCR1C,TIMSK1,TIFR1,PCICR,PCMSK0,PCMSK1,PCMSK2,PCMSK3,PCIFR;
+extern volatile uint16_t ADC,TCNT1,OCR1A,OCR1B,ICR1;
+#define PA0 0
+#define PA1 1
+#define PA2 2
+#define PA3 3
+#define PA4 4
+#define PA5 5
+#define PA6 6
+#define PA7 7
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PC4 4
+#define PC5 5
+#define PC6 6
+#define PC7 7
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+#define DDB0 0
+#define DDB1 1
+#define DDB2 2
+#define DDB3 3
+#define DDB4 4
+#define DDB5 5
+#define DDB7 7
+#define DDC2 2
+#define DDC3 3
+#define DDC4 4
+#define DDC5 5
+#define DDC6 6
+#define DDC7 7
+#define DDD2 2
+#define DDD3 3
+#define DDD7 7
+#define WGM01 1
+#define WGM21 1
+#define WGM12 3
+#define CS00 0
+#define CS01 1
+#define CS02 2
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define OCIE0A 1
+#define OCIE2A 1
+#define OCIE2B 2
+#define OCF2A 1
+#define OCF2B 2
+#define TOIE1 0
+#define OCIE1A 1
+#define OCIE1B 2
+#define TOV1 0
+#define OCF1A 1
+#define OCF1B 2
+#define ADEN 7
+#define ADSC 6
+#define ADIF 4
+#define ADPS2 2
+#define ADPS1 1
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PCIE3 3
+#define PCINT0 0
+#define PCINT1 1
+#define PCINT24 0
+#define PCINT25 1
+#define PCINT26 2
+#define PCINT27 3
+#define PCINT28 4
+#define PCINT29 5
+#define PCINT30 6
+#define PCINT31 7
+#define _BV(x) (1<<(x))
+#define _SFR_IO_ADDR(x) x
@@ -0,0 +1,12 @@
+#pragma once
+#include <string.h>
+#include <stdio.h>
+#define PROGMEM
+#define PSTR(s) (s)
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define sprintf_P sprintf
+#define printf_P printf
+#define pgm_read_byte(a) (*(const uint8_t*)(a))
+#define pgm_read_word(a) (*(const uint16_t*)(a))
+#define pgm_read_dword(a) (*(const uint32_t*)(a))
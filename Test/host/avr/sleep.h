@@ -0,0 +1,6 @@
+#pragma once
+#define SLEEP_MODE_IDLE 0
+#define set_sleep_mode(x)
+#define sleep_enable()
+#define sleep_cpu()
+#define sleep_disable()
@@ -0,0 +1 @@
+#include "Config.h"
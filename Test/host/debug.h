@@ -0,0 +1,3 @@
+#pragma once
+#define DPRINT(...)
+#define CHECKPOINT
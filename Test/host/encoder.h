@@ -0,0 +1,6 @@
+#pragma once
+#include <stdint.h>
+void Encoder_MainFunction(void);
+void Encoder_Init(uint8_t);
+void Encoder_SetAcceleration(uint8_t,uint8_t,uint8_t,uint8_t);
+int16_t Encoder_GetAndResetPosition(void);
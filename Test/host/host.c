@@ -0,0 +1,277 @@
+//
+// Host build of the firmware for the tests in Test/, see dcghost.py.
+//
+// The headers in this directory replace avr-libc and the Common libraries. This file replaces
+// the hardware: the registers are plain variables, the DACs record the values shifted out, the
+// ADC returns the values set by the test. host_slot() runs the interrupts of one Timer2 slot.
+//
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "avr/io.h"
+#include "avr/pgmspace.h"
+#include "avr/eeprom.h"
+#include "Parser.h"
+#include "Uart.h"
+#include "Lcd.h"
+#include "Encoder.h"
+#include "I2CRegister.h"
+#include "config.h"
+#include "dcg.h"
+#include "timer.h"
+
+volatile uint8_t PORTA, PORTB, PORTC, PORTD, PINA, PINB, PINC, PIND, DDRA, DDRB, DDRC, DDRD, SREG;
+volatile uint8_t OCR0A, OCR0B, TCNT0, TCCR0A, TCCR0B, TIMSK0, OCR2A, OCR2B, TCNT2, TCCR2A, TCCR2B, TIMSK2, TIFR2, TIFR0, ADMUX, ADCSRA, GTCCR, ASSR;
+volatile uint8_t TCCR1A, TCCR1B, TCCR1C, TIMSK1, TIFR1, PCICR, PCMSK0, PCMSK1, PCMSK2, PCMSK3, PCIFR;
+volatile uint16_t ADC, TCNT1, OCR1A, OCR1B, ICR1;
+
+char g_cSerInpStr[64];
+
+void TIMER2_COMPA_vect(void);
+void TIMER2_COMPB_vect(void);
+void TIMER1_OVF_vect(void);
+#ifdef WAVETICK
+void TIMER1_COMPA_vect(void);
+#endif
+void init_Arb_RAMarray(void);
+
+//*** values seen by the test ***
+uint8_t  host_err = NoErr;          // last prompt of the parser
+uint16_t host_adc_u;                // raw LTC1864 value with the ADC MUX on U (PC6 = 1)
+uint16_t host_adc_i;
+uint16_t host_dac_u;                // last value loaded into the DAC of U (DUAL_DAC) or held by the S&H of U
+uint16_t host_dac_i;
+uint16_t host_dac_out;              // last value shifted out by the single DAC
+uint32_t host_dac_loads;            // number of values shifted out
+uint32_t host_sh_switches;          // number of times a S&H was connected to the single DAC
+uint32_t host_sh_hold[2];           // longest time the S&H of U/I was disconnected, in slots
+uint32_t host_slots;                // Timer2 slots run
+
+//*** libraries ***
+void LIMIT_FLOAT(float *param, float min, float max)
+{
+    if (*param < min) *param = min;
+    if (*param > max) *param = max;
+}
+
+void LIMIT_UINT8(uint8_t *param, uint8_t min, uint8_t max)
+{
+    if (*param < min) *param = min;
+    if (*param > max) *param = max;
+}
+
+void LIMIT_INT16(int16_t *param, int16_t min, int16_t max)
+{
+    if (*param < min) *param = min;
+    if (*param > max) *param = max;
+}
+
+void LIMIT_UINT16(uint16_t *param, uint16_t min, uint16_t max)
+{
+    if (*param < min) *param = min;
+    if (*param > max) *param = max;
+}
+
+void SerPrompt(uint8_t Err, uint8_t Status)
+{
+    (void)Status;
+    host_err = Err;
+}
+
+void jobParseData(void) {}
+void Uart_InitUBRR(uint8_t Ubrr) { (void)Ubrr; }
+uint8_t Uart_SetTxData(uint8_t* p, uint8_t n, uint8_t f) { (void)p; (void)f; return n; }
+uint8_t Uart_GetRxData(uint8_t* p, uint8_t n, uint8_t f) { (void)p; (void)n; (void)f; return 0; }
+uint8_t Lcd_Init(void) { return 0; }
+void Lcd_Write_P(uint8_t x, uint8_t y, uint8_t n, const char* s) { (void)x; (void)y; (void)n; (void)s; }
+void Lcd_Write(uint8_t x, uint8_t y, uint8_t n, const char* s) { (void)x; (void)y; (void)n; (void)s; }
+void Lcd_OverWrite_P(uint8_t x, uint8_t y, uint8_t n, const char* s) { (void)x; (void)y; (void)n; (void)s; }
+uint8_t Lcd_GetButton(void) { return 0; }
+void Encoder_MainFunction(void) {}
+void Encoder_Init(uint8_t Pre) { (void)Pre; }
+void Encoder_SetAcceleration(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { (void)a; (void)b; (void)c; (void)d; }
+int16_t Encoder_GetAndResetPosition(void) { return 0; }
+void I2C_Init(void) {}
+uint8_t I2CRegister_Write(uint8_t a, uint8_t r, uint8_t n, uint8_t* p) { (void)a; (void)r; (void)n; (void)p; return 1; }
+uint8_t I2CRegister_Read(uint8_t a, uint8_t r, uint8_t n, uint8_t* p) { (void)a; (void)r; memset(p, 0, n); return 1; }
+void _delay_loop_2(uint16_t n) { (void)n; }
+void _delay_us(double us) { (void)us; }
+void _delay_ms(double ms) { (void)ms; }
+
+// EEMEM is empty, the EEPROM variables are in RAM
+void eeprom_write_block(const void* src, void* dst, size_t n) { memcpy(dst, src, n); }
+void eeprom_update_block(const void* src, void* dst, size_t n) { memcpy(dst, src, n); }
+void eeprom_read_block(void* dst, const void* src, size_t n) { memcpy(dst, src, n); }
+uint16_t eeprom_read_word(const uint16_t* p) { return *p; }
+uint8_t eeprom_read_byte(const uint8_t* p) { return *p; }
+void eeprom_write_byte(uint8_t* p, uint8_t v) { *p = v; }
+
+//*** dcg-hw-asm.S ***
+// returns the conversion started by the read before and starts the next one with the MUX as it is now
+uint16_t ShiftIn1864(void)
+{
+    static uint16_t Conversion;
+    uint16_t Value = Conversion;
+
+    Conversion = (PORTC & (1<<PC6)) ? host_adc_u : host_adc_i;
+    return Value;
+}
+
+#ifdef DUAL_DAC
+void ShiftOut1655(uint16_t Value, uint8_t Channel)
+{
+    host_dac_loads++;
+    if (Channel)
+    {
+        host_dac_i = Value;
+    }
+    else
+    {
+        host_dac_u = Value;
+    }
+}
+#else
+void ShiftOut1655(uint16_t Value)
+{
+    host_dac_loads++;
+    host_dac_out = Value;
+}
+#endif
+
+void ShiftOut1257(uint16_t Value)
+{
+    host_dac_loads++;
+    host_dac_out = Value;
+}
+
+#ifndef DUAL_DAC
+// the S&H of U is connected with PC4 = 1, the one of I with PC5 = 0
+static void host_sample_hold(void)
+{
+    static uint8_t Connected;
+    static uint32_t Since[2] = {UINT32_MAX, UINT32_MAX};
+    uint8_t Now = ((PORTC & (1<<PC4)) ? 1 : 0) | ((PORTC & (1<<PC5)) ? 0 : 2);
+    uint8_t c;
+
+    if (Now & ~Connected)
+    {
+        host_sh_switches++;
+    }
+    for (c = 0; c < 2; c++)
+    {
+        if ((Connected & ~Now) & (1 << c))
+        {
+            Since[c] = host_slots;
+        }
+        if ((Now & ~Connected) & (1 << c) && (Since[c] != UINT32_MAX) && (host_slots - Since[c] > host_sh_hold[c]))
+        {
+            host_sh_hold[c] = host_slots - Since[c];
+        }
+    }
+    Connected = Now;
+    if (Now & 1)
+    {
+        host_dac_u = host_dac_out;
+    }
+    if (Now & 2)
+    {
+        host_dac_i = host_dac_out;
+    }
+}
+#endif
+
+//*** start like main() without the waits, the timers run by host_slot() only ***
+void host_init(void)
+{
+    PORTB = (1<<PB7)|(1<<PB6)|(1<<PB4)|(1<<PB1)|(1<<PB0);
+#ifdef DUAL_DAC
+    PORTC = (1<<PC5)|(1<<PC4)|(1<<PC3)|(1<<PC2)|(1<<PC1)|(1<<PC0);
+#else
+    PORTC = (1<<PC3)|(1<<PC2)|(1<<PC1)|(1<<PC0);
+#endif
+    PORTD = (1<<PD7)|(1<<PD6)|(1<<PD5)|(1<<PD2);
+    PIND = 0xff;
+
+    Timer_Init();
+    init_Arb_RAMarray();
+    Status.u8 = 0;
+    InitScales();
+
+    LockRangeU = Params.LockRangeU;
+    LockRangeI = Params.LockRangeI;
+    DCVoltMod = 1;
+    DCAmpMod = 1;
+    wVoltage = 0;
+    wCurrent = Params.InitCurrent;
+    ArbActive = 0;
+    CheckLimits();
+    SetLevelDAC();
+    PORTC |= (1<<PC7);
+
+    Timer_StartTimers();
+}
+
+//*** one Timer2 slot of 500us: compare A, its sub-states by compare B and the waveform ticks of Timer1 ***
+void host_slot(void)
+{
+    const uint16_t Slot = F_CPU / 2000;
+    uint16_t Start = TCNT1;
+    uint8_t n;
+
+    host_slots++;
+    TCNT2 = 0;
+    TIMER2_COMPA_vect();
+    for (n = 0; (TIMSK2 & (1<<OCIE2B)) && (n < 16); n++)
+    {
+        TCNT2 = OCR2B;
+        TIMER2_COMPB_vect();
+#ifndef DUAL_DAC
+        host_sample_hold();
+#endif
+    }
+#ifndef DUAL_DAC
+    host_sample_hold();
+#endif
+
+#ifdef WAVETICK
+    while ((TIMSK1 & (1<<OCIE1A)) && ((uint16_t)(OCR1A - Start) < Slot))
+    {
+        TCNT1 = OCR1A;
+        TIMER1_COMPA_vect();
+    }
+#endif
+    TCNT1 = Start + Slot;
+    if (TCNT1 < Start)
+    {
+        TIMER1_OVF_vect();
+    }
+}
+
+void host_run_ms(uint32_t Ms)
+{
+    while (Ms--)
+    {
+        host_slot();
+        host_slot();
+    }
+}
+
+// calibration of the firmware for the expected values
+int16_t host_adc_offset_u(uint8_t Range)
+{
+    return Params.ADCUOffsets[Range];
+}
+
+int16_t host_adc_offset_i(uint8_t Range)
+{
+    return Params.ADCIOffsets[Range];
+}
+
+// parser command as from the bus, returns the prompt
+uint8_t host_set(uint8_t SubCh, float Param)
+{
+    host_err = NoErr;
+    ParseSetParam(SubCh, Param);
+    return host_err;
+}
@@ -0,0 +1,3 @@
+#pragma once
+#define ATOMIC_BLOCK(x) for(int _i=1;_i;_i=0)
+#define ATOMIC_RESTORESTATE
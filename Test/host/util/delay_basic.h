@@ -0,0 +1,3 @@
+#pragma once
+#include <stdint.h>
+void _delay_loop_2(uint16_t);
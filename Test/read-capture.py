@@ -0,0 +1,102 @@
+#! /usr/bin/python
+
+#
+# Arm the capture buffer of the DCG (scope mode), wait for the record and read it back (SubCh 128..137).
+#
+# Output file: one sample per line, "time U I", time in ms relative to the trigger, U and I as raw ADC values.
+#
+import argparse
+import time
+#
+import ctlab
+import ctlab_helper
+
+CAPTURE_DONE = 3
+SAMPLE_MS = 2       # a value of U every 2ms, times the decimation
+
+
+def get_int(lab, subch):
+    return int(lab.read_value(lab.dcg2, '%d?' % subch))
+
+
+def parse_frame(answer):
+    # NNNN UUUU IIII ... CC, the sum of all bytes incl. CC is 0 (mod 256)
+    data = bytes.fromhex(answer[answer.find(b'=') + 1:].decode())
+    if sum(data) & 0xff:
+        raise ValueError('checksum error: %s' % answer)
+    start = (data[0] << 8) | data[1]
+    samples = []
+    for i in range(2, len(data) - 1, 4):
+        samples.append(((data[i] << 8) | data[i + 1], (data[i + 2] << 8) | data[i + 3]))
+    return start, samples
+
+
+def read_record(lab):
+    count = get_int(lab, 134)
+    lab.send_command(lab.dcg2, '136=0')
+    samples = []
+    while len(samples) < count:
+        start, frame = parse_frame(lab.send_command_result(lab.dcg2, '137?'))
+        if start != len(samples) or not frame:
+            raise ValueError('unexpected frame at sample %d' % start)
+        samples += frame
+    return samples
+
+
+def main():
+
+    print("Read the capture buffer of the DCG")
+
+    # From Config-File
+    (serial_port, unic_config) = ctlab_helper.read_configfile('config.ini')
+    parser = argparse.ArgumentParser(description='Capture U and I in the DCG and read the record.', prefix_chars='-')
+    parser.add_argument("-p", "--port", help="Used port nummer")
+    parser.add_argument("-f", "--file", required=True, help="Filename of the record")
+    parser.add_argument("--pre", type=int, default=16, help="Samples before the trigger")
+    parser.add_argument("--post", type=int, default=48, help="Samples from the trigger on")
+    parser.add_argument("-d", "--decimation", type=int, default=1, help="Sample every n-th value (2ms)")
+    parser.add_argument("-s", "--source", type=int, default=0,
+                        help="Trigger: 0 = now, 1 = arbitrary sequence, 2 = ripple, 3/4/5 = U rising/falling/leaving window, "
+                             "6/7/8 = the same for I, 9 = relay switch")
+    parser.add_argument("-l", "--level", type=float, default=0.0, help="Threshold in V or A, lower level of the window")
+    parser.add_argument("--high", type=float, default=0.0, help="Upper level of the window in V or A")
+    parser.add_argument("-t", "--timeout", type=float, default=10.0, help="Seconds to wait for the trigger")
+    args = parser.parse_args()
+    if args.port is not None:
+        serial_port = args.port
+
+    print('port =', serial_port)
+
+    lab = ctlab.ctlab(serial_port)
+    lab.check_devices(verbose=True)
+
+    lab.send_command(lab.dcg2, '130=%d' % args.pre)
+    lab.send_command(lab.dcg2, '131=%d' % args.post)
+    lab.send_command(lab.dcg2, '132=%d' % args.decimation)
+    lab.send_command(lab.dcg2, '133=%d' % args.source)
+    lab.send_command(lab.dcg2, '138=%f' % args.level)
+    lab.send_command(lab.dcg2, '139=%f' % args.high)
+    lab.send_command(lab.dcg2, '128=1')
+    if args.source == 0:
+        time.sleep(args.pre * args.decimation * SAMPLE_MS / 1000.0)
+        lab.send_command(lab.dcg2, '128=2')
+
+    deadline = time.time() + args.timeout
+    while get_int(lab, 129) != CAPTURE_DONE:
+        if time.time() > deadline:
+            print("no trigger")
+            lab.send_command(lab.dcg2, '128=0')
+            return
+        time.sleep(0.1)
+
+    trigger = get_int(lab, 135)
+    age = (get_int(lab, 141) - get_int(lab, 140)) / 10.0
+    samples = read_record(lab)
+    print('samples =', len(samples), ', trigger at', trigger, ', %.1f ms ago' % age)
+
+    with open(args.file, 'w') as f:
+        for n, (u, i) in enumerate(samples):
+            f.write('%d %d %d\n' % ((n - trigger) * args.decimation * SAMPLE_MS, u, i))
+
+
+main()
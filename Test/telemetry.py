@@ -0,0 +1,131 @@
+#! /usr/bin/python
+
+#
+# Subscribe one or more DCGs to the telemetry records (SubCh 216..220) and log U, I and P without polling.
+#
+# Each device gets a slot of its own within the interval, the syncs (216) are sent one after the other and the
+# offsets (217) corrected by the time between them, so the records of the devices don't collide on the bus.
+# The crystals of the devices drift apart, every 10s they are synced again (217) in the time after the last slot.
+# Output file: one record per line, "time address number U I P status", time in s on the host.
+#
+import argparse
+import re
+import time
+#
+import ctlab
+import ctlab_helper
+
+SLOT_MS = 16        # TELESLOT, a record takes 10ms at 38400 Bd
+SYNC_MS = 10        # a sync command and its [OK]
+RESYNC_S = 10       # TELERESYNC
+RECORD = re.compile(rb"#(\d+):220=([0-9A-Fa-f]{30})")
+
+
+def int32(data):
+    value = (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3]
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def parse_record(line):
+    # NN UUUUUUUU IIIIIIII PPPPPPPP SS CC, the sum of all bytes incl. CC is 0 (mod 256)
+    m = RECORD.search(line)
+    if m is None:
+        return None
+    data = bytes.fromhex(m.group(2).decode())
+    if sum(data) & 0xff:
+        raise ValueError('checksum error: %s' % line)
+    return (int(m.group(1)), data[0], int32(data[1:5]) * 1e-6, int32(data[5:9]) * 1e-8, int32(data[9:13]) * 1e-6,
+            data[13])
+
+
+def subscribe(lab, devices, interval, deadband_u, deadband_i):
+    for dev in devices:
+        lab.send_command(dev, '216=0')
+        lab.send_command(dev, '218=%f' % deadband_u)
+        lab.send_command(dev, '219=%f' % deadband_i)
+        lab.send_command(dev, '217=%d' % (SLOT_MS * devices.index(dev)))
+    return sync(lab, devices, interval)
+
+
+def sync(lab, devices, interval=None):
+    # 216 starts the records, 217 alone syncs again. Returns the time of the first sync, the slots of
+    # the devices follow SLOT_MS apart every interval from it.
+    timeout, lab.ser.timeout = lab.ser.timeout, 0.1
+    start = time.time()
+    for n, dev in enumerate(devices):
+        offset = SLOT_MS * n - int((time.time() - start) * 1000)
+        if offset < 0:
+            print("WARNING: device %d synced %d ms late, records may collide" % (dev, -offset))
+            offset = 0
+        lab.send_command_only(dev, '217=%d' % offset)
+        if interval is not None:
+            lab.send_command_only(dev, '216=%d' % interval)
+        lab.ser.readline()      # [OK] of 217
+        if interval is not None:
+            lab.ser.readline()  # [OK] of 216
+    lab.ser.timeout = timeout
+    return start
+
+
+def main():
+
+    print("Telemetry of the DCG")
+
+    # From Config-File
+    (serial_port, unic_config) = ctlab_helper.read_configfile('config.ini')
+    parser = argparse.ArgumentParser(description='Log the telemetry records of one or more DCGs.', prefix_chars='-')
+    parser.add_argument("-p", "--port", help="Used port nummer")
+    parser.add_argument("-f", "--file", required=True, help="Filename of the log")
+    parser.add_argument("-d", "--devices", type=int, nargs='+', required=True, help="Addresses of the DCGs")
+    parser.add_argument("-i", "--interval", type=int, default=100, help="ms between the records of a device")
+    parser.add_argument("--deadband-u", type=float, default=0.0, help="V, records only on a change of U beyond it")
+    parser.add_argument("--deadband-i", type=float, default=0.0, help="A, the same for I")
+    parser.add_argument("-t", "--time", type=float, default=10.0, help="Seconds to log")
+    args = parser.parse_args()
+    if args.port is not None:
+        serial_port = args.port
+
+    print('port =', serial_port)
+    if SLOT_MS * len(args.devices) > args.interval:
+        print("WARNING: %d devices need an interval of %d ms at least" % (len(args.devices), SLOT_MS * len(args.devices)))
+
+    frame = SLOT_MS * len(args.devices)
+    resync = frame + SYNC_MS * len(args.devices) <= args.interval
+    if not resync:
+        print("WARNING: no time for the sync after the last slot, the devices drift apart")
+
+    lab = ctlab.ctlab(serial_port)
+    synced = subscribe(lab, args.devices, args.interval, args.deadband_u, args.deadband_i)
+    lab.ser.timeout = 0.002     # the time after the last slot must not be missed
+
+    records = 0
+    errors = 0
+    start = time.time()
+    line = b''
+    with open(args.file, 'w') as f:
+        while time.time() - start < args.time:
+            phase = (time.time() - synced) * 1000 % args.interval
+            if resync and not line and time.time() - synced > RESYNC_S and \
+                    frame <= phase <= args.interval - SYNC_MS * len(args.devices):
+                synced = sync(lab, args.devices)
+            line += lab.ser.readline()
+            if not line.endswith(b'\n'):
+                continue
+            line, complete = b'', line
+            try:
+                record = parse_record(complete)
+            except ValueError as e:
+                print(e)
+                errors += 1
+                continue
+            if record is not None:
+                f.write('%.3f %d %d %.6f %.9f %.6f %d\n' % ((time.time() - start,) + record))
+                records += 1
+
+    for dev in args.devices:
+        lab.send_command_only(dev, '216=0')
+        time.sleep(0.05)
+    print('records =', records, ', checksum errors =', errors)
+
+
+main()
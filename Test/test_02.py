@@ -0,0 +1,145 @@
+#! /usr/bin/python
+
+#
+# Host side check of the arbitrary mode interpolation, no hardware needed.
+#
+# Loads sequences by the bus commands 186/187/188 into the host build of the firmware (dcghost.py),
+# plays them from RAM (182 = 2) and compares the DAC values of ISR(TIMER2_COMPA_vect) with the former
+# per tick division
+#     ArbDAC[i] + (ArbDAC[i+1] - ArbDAC[i]) * ArbTmr / ArbT[i]
+# for the builds DUAL_DAC (1 ms ticks), DUAL_DAC + DEBUGSTDHW and the single DAC (2 ms ticks).
+# A sequence longer than the table of the ISR has to end with its last point in the table.
+# Steps in 100 ms and min units are checked against the straight line, up to 10 h (a slope per ms
+# ended a 600 min step hundreds of LSB short).
+#
+import ctypes
+import random
+import sys
+
+import dcghost
+
+print("Test02")
+print("Arbitrary mode: DDA interpolation of the firmware vs. division, host build")
+
+UNIT_MS = [1, 100, 1000, 60000]
+TABLE = 50          # ARBINDEXMAX, longer sequences are cut
+
+
+def c_div(a, b):
+    # C integer division, truncating towards zero
+    q = abs(a) // abs(b)
+    return q if (a >= 0) == (b > 0) else -q
+
+
+def load(dcg, points, unit=0):
+    prompts = [dcg.set(250, 1), dcg.set(188, 1), dcg.set(178, unit)]
+    for volt, time in points:
+        prompts += [dcg.set(186, volt), dcg.set(187, time)]
+    prompts += [dcg.set(250, 1), dcg.set(188, 2)]
+    if any(p != dcghost.NoErr for p in prompts):
+        raise RuntimeError("load failed: %s" % prompts)
+
+
+def start(dcg, points, unit=0):
+    # plays the sequence once, returns the DAC values of the points as scaled by SetLevelDAC
+    load(dcg, points, unit)
+    dcg.set(189, 0)
+    dcg.set(184, 1)
+    dcg.set(182, 2)
+    table = dcg.var(ctypes.c_void_p, "ArbTableNext").value or dcg.var(ctypes.c_void_p, "ArbTablePlay").value
+    return [ctypes.c_uint16.from_address(table + 2 * i).value for i in range(min(len(points), TABLE))]  # DAC[] comes first in ARBTABLE
+
+
+def expected(dac, times, step, ticks):
+    # the former ISR with the division, one value per tick of step ms
+    out = []
+    index, tmr = 0, 0
+    for _ in range(ticks):
+        if times[index] == 0:
+            out.append(dac[index])
+            continue
+        if tmr < times[index]:
+            out.append(dac[index] + c_div((dac[index + 1] - dac[index]) * tmr, times[index]))
+            tmr += step
+        while tmr >= times[index]:
+            tmr -= times[index]
+            index += 1
+            if times[index] == 0:
+                break
+    return out
+
+
+def compare(want, got):
+    # the output starts a few ms after 182, the DAC follows the ISR by a slot
+    best = None
+    for offset in range(8):
+        part = got[offset:offset + len(want)]
+        diff = max(abs(a - b) for a, b in zip(want, part))
+        if best is None or diff < best:
+            best = diff
+    return best
+
+
+sequences = {
+    "ISO4":   ([1.0, 1.0, 0.416667, 0.416667, 0.666667, 0.666667, 1.0], [200, 20, 50, 10, 100, 20, 0]),
+    "ISO4m":  ([1.0, 0.916667, 0.416667, 0.5, 0.666667, 0.75, 1.0], [200, 20, 50, 10, 100, 20, 0]),
+    "Graetz": ([1.0, 0.9511, 0.8090, 0.5878, 0.3090, 0.0, 0.3090, 0.5878, 0.8090, 0.9511, 1.0], [1] * 10 + [0]),
+    "3Peaks": ([1.0, 1.0, 0.416667, 1.0, 1.0, 0.666667, 1.0, 1.0, 0.833333, 1.0, 1.0], [198, 2, 2, 8, 2, 2, 8, 2, 2, 2, 0]),
+}
+
+rnd = random.Random(4711)
+for n in range(10):
+    count = rnd.randint(2, 30)
+    volts = [rnd.random() for _ in range(count)]
+    times = [rnd.choice([1, 2, 3, 7, 100, 999, 16000]) for _ in range(count - 1)] + [0]
+    sequences["random%02d" % n] = (volts, times)
+volts = [rnd.random() for _ in range(TABLE + 10)]
+sequences["cut%02d" % (TABLE + 10)] = (volts, [rnd.choice([1, 2, 7, 100]) for _ in range(TABLE + 9)] + [0])
+
+failed = 0
+for defines, step in ((("DUAL_DAC",), 1), (("DUAL_DAC", "DEBUGSTDHW"), 2), ((), 2)):
+    build = "+".join(defines) or "single DAC"
+    for name, (volts, times) in sorted(sequences.items()):
+        dcg = dcghost.load(*defines)
+        dcg.set(0, 10.0)
+        dcg.run_ms(10)
+        dac = start(dcg, list(zip(volts, times)))
+        times = times[:len(dac) - 1] + [0]      # the last point of a cut sequence gets the end marker
+        total = sum(times)
+        got = []
+        for _ in range(min(total, 100000) + 10):
+            dcg.run_ms(1)
+            got.append(dcg.dac_u)
+        want = [v for v in expected(dac, times, step, (min(total, 100000) + step - 1) // step) for _ in range(step)]
+        diff = compare(want, got)
+        if diff > 1:
+            failed += 1
+        print("%-21s %-9s max diff %d LSB  %s" % (build, name, diff, "ok" if diff <= 1 else "FAILED"))
+
+# long steps in a time unit: the straight line at the end of every unit and in between
+for defines in (("DUAL_DAC",), ()):
+    build = "+".join(defines) or "single DAC"
+    for unit, count, volts, check in ((1, 30, [0.0, 1.0, 0.5], 50), (3, 600, [0.0, 0.0153, 0.0], 30000), (3, 600, [1.0, 0.0, 1.0], 30000)):
+        dcg = dcghost.load(*defines)
+        dcg.set(0, 10.0)
+        dcg.run_ms(10)
+        dac = start(dcg, [(volts[0], count), (volts[1], count), (volts[2], 0)], unit)
+        ms = count * UNIT_MS[unit]
+        got = []
+        for t in range(check, ms, check):
+            dcg.run_ms(check)
+            got.append((t, dcg.dac_u))
+        # the output starts a few ms after 182, see compare()
+        diff = min(max(abs(v - (dac[0] + (dac[1] - dac[0]) * (t - offset) / float(ms))) for t, v in got)
+                   for offset in range(8))
+        ok = diff <= 2.0        # between two units the truncated slope per ms adds up to 1 LSB
+        if not ok:
+            failed += 1
+        print("%-21s %3d x %-5s %5d -> %5d LSB: max diff %.1f LSB  %s"
+              % (build, count, ["ms", "100ms", "s", "min"][unit], dac[0], dac[1], diff, "ok" if ok else "FAILED"))
+
+print("---------------------------------------")
+if failed:
+    print("%d runs exceed the limit" % failed)
+    sys.exit(1)
+print("all runs within the limit")
@@ -0,0 +1,89 @@
+#! /usr/bin/python
+
+#
+# Host side check of the sample&hold refresh of the single DAC hardware, no hardware needed.
+#
+# Runs the single DAC build of the firmware (dcghost.py) with SHRefresh (57) = 1, which loads the
+# DAC and switches the S&H in every slot like the former code, and with longer refresh periods.
+# Reported are the DAC loads per second and the longest time a S&H holds a value (droop).
+# The values held by both S&H have to be the same as with SHRefresh = 1 in every ms, so a new
+# value reaches its S&H in the slot it is calculated in.
+#
+import ctypes
+import sys
+
+import dcghost
+
+print("Test03")
+print("Single DAC: S&H refresh with change tracking vs. every slot, host build")
+
+MS = 5000
+SETTLE = 0.025      # ms from the start of a slot until the S&H is connected
+
+
+def table(dcg, points):
+    dcg.set(250, 1)
+    dcg.set(188, 1)
+    for volt, time in points:
+        dcg.set(186, volt)
+        dcg.set(187, time)
+    dcg.set(250, 1)
+    dcg.set(188, 2)
+    dcg.set(189, 0)
+    dcg.set(184, 255)
+    dcg.set(182, 2)
+
+
+def i_steps(dcg, ms):
+    if ms % 250 == 0:
+        dcg.set(1, 0.05 + (ms // 250) % 3 * 0.05)
+
+
+cases = {
+    "static":  (lambda dcg: None, None),
+    "U ramp":  (lambda dcg: table(dcg, [(0.0, 4000), (1.0, 0)]), None),
+    "U steps": (lambda dcg: table(dcg, [(0.2, 100), (0.2, 1), (0.8, 100), (0.8, 1), (0.2, 0)]), None),
+    "I steps": (lambda dcg: None, i_steps),
+    "U ramp, I steps": (lambda dcg: table(dcg, [(0.0, 4000), (1.0, 0)]), i_steps),
+}
+
+
+def run(refresh, setup, every_ms):
+    dcg = dcghost.load()
+    dcg.set(57, refresh)
+    dcg.set(0, 10.0)
+    dcg.set(1, 0.1)
+    setup(dcg)
+    dcg.run_ms(20)
+    loads = dcg.var(ctypes.c_uint32, "host_dac_loads")
+    hold = dcg.array(ctypes.c_uint32, "host_sh_hold", 2)
+    start = loads.value
+    hold[0] = hold[1] = 0
+    trace = []
+    for ms in range(MS):
+        if every_ms:
+            every_ms(dcg, ms)
+        dcg.run_ms(1)
+        trace.append((dcg.dac_u, dcg.dac_i))
+    return (loads.value - start) * 1000.0 / MS, [h * 0.5 + SETTLE for h in hold], trace
+
+
+failed = 0
+for name, (setup, every_ms) in sorted(cases.items()):
+    old_loads, old_hold, old_trace = run(1, setup, every_ms)
+    print("%-15s every slot:     %6.1f loads/s, max hold U %5.3fms I %5.3fms" % (name, old_loads, old_hold[0], old_hold[1]))
+    for refresh in (2, 4, 8):
+        loads, hold, trace = run(refresh, setup, every_ms)
+        bound = 2 * refresh - 1 + SETTLE
+        late = sum(1 for a, b in zip(old_trace, trace) if a != b)
+        ok = late == 0 and max(hold) <= bound + 1e-9 and loads <= old_loads
+        if not ok:
+            failed += 1
+        print("%-15s SHRefresh=%d:   %6.1f loads/s, max hold U %5.3fms I %5.3fms (bound %6.3fms), %d ms differ  %s"
+              % (name, refresh, loads, hold[0], hold[1], bound, late, "ok" if ok else "FAILED"))
+
+print("---------------------------------------")
+if failed:
+    print("%d runs failed" % failed)
+    sys.exit(1)
+print("all runs ok, every new value output in its slot, hold time within 2 * SHRefresh - 1 ms")
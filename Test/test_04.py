@@ -0,0 +1,79 @@
+#! /usr/bin/python
+
+#
+# Host side check of the fixed point measurement of jobGetValues, no hardware needed.
+#
+# Injects raw ADC values into the host build of the firmware (dcghost.py) with the default calibration
+# and compares xVoltage_uV and xCurrent_10nA with the exact value of the former float calculation
+# (raw + offset) * LSB, for all ranges, the 16 bit LTC1864 and the internal 10 bit ADC.
+# The error has to stay within 2 uV/10nA or 1/256 LSB (the multiplier is a float product on the AVR,
+# about 16 units per 2^28 in the 2A range), the full scale of every range must not saturate.
+#
+import ctypes
+import sys
+
+import dcghost
+
+print("Test04")
+print("Fixed point measurement of jobGetValues vs. float, host build")
+
+INT32_MAX = 0x7fffffff
+
+# set values which select the ranges (SetLevelDAC)
+RANGES_U = [("U 12V", 0, 5.0), ("U 30V", 1, 20.0)]
+RANGES_I = [("I 2mA", 0, 0.001), ("I 20mA", 1, 0.01), ("I 200mA", 2, 0.1), ("I 2A", 3, 1.0)]
+
+dcg = dcghost.load("DUAL_DAC")
+dcg.lib.host_adc_offset_u.restype = ctypes.c_int16
+dcg.lib.host_adc_offset_i.restype = ctypes.c_int16
+adc_lsb_u = dcg.array(ctypes.c_float, "ADCLSBU", 2)
+adc_lsb_i = dcg.array(ctypes.c_float, "ADCLSBI", 4)
+
+
+def measure(raw, bits, first):
+    if bits == 16:
+        dcg.adc(raw, raw)
+    else:
+        dcg.var(ctypes.c_uint16, "ADC").value = raw
+    dcg.run_ms(4)
+    for _ in range(11 if first else 1):     # 10 runs are skipped after a range switch
+        dcg.lib.jobGetValues()
+    return dcg.var(ctypes.c_int32, "xVoltage_uV").value, dcg.var(ctypes.c_int32, "xCurrent_10nA").value
+
+
+failed = 0
+for bits in (16, 10):
+    if bits == 10:
+        dcg.set(250, 1)
+        dcg.set(167, 1)                     # options: LTC1655, no LTC1864
+    adc_max = 1 << bits
+    for channel, ranges in (("U", RANGES_U), ("I", RANGES_I)):
+        for name, rng, value in ranges:
+            dcg.set(0 if channel == "U" else 1, value)
+            dcg.run_ms(4)
+            if dcg.var(ctypes.c_uint8, "Range" + channel).value != rng:
+                raise RuntimeError("%s not selected" % name)
+            if channel == "U":
+                lsb, offset, unit = adc_lsb_u[rng] * 1e6, dcg.lib.host_adc_offset_u(rng), "uV"
+            else:
+                lsb, offset, unit = adc_lsb_i[rng] * 1e8, dcg.lib.host_adc_offset_i(rng), "10nA"
+            worst = 0.0
+            first = True
+            for raw in list(range(0, adc_max, adc_max // 128)) + [adc_max - 1]:
+                got = measure(raw, bits, first)[0 if channel == "U" else 1]
+                first = False
+                exact = (raw + offset) * lsb
+                worst = max(worst, abs(got - exact))
+            full = (adc_max - 1 + offset) * lsb
+            ok = worst <= max(2.0, lsb / 256) and got < INT32_MAX
+            if not ok:
+                failed += 1
+            print("%-8s %2d bit: full scale %10.6f %s, max error %5.2f %s  %s"
+                  % (name, bits, full * (1e-6 if channel == "U" else 1e-8), channel.replace("U", "V").replace("I", "A"),
+                     worst, unit, "ok" if ok else "FAILED"))
+
+print("---------------------------------------")
+if failed:
+    print("%d runs failed" % failed)
+    sys.exit(1)
+print("all runs ok, fixed point within 2 uV/10nA or 1/256 LSB of the float calculation")
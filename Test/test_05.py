@@ -0,0 +1,107 @@
+#! /usr/bin/python
+
+#
+# Host side check of the statistics of U, I and P (StatStore in timer.c, StatSnapshot in dcg.c), no hardware needed.
+#
+# Feeds periodic raw values of U and I into the ADC of the host build of the firmware (dcghost.py), one pair
+# per 2ms in step with the ADC MUX, and reads min, max, mean and RMS of the last complete window by 142/145/146..149.
+# The window is a multiple of the period, so the result doesn't depend on where the window starts. They are compared against
+# the exact float calculation on (raw + offset) * LSB with the default calibration. The RMS of P is accumulated
+# from the squares of P >> 16, its error has to stay within 0.1% of the full scale, the others within 0.01%.
+#
+import ctypes
+import math
+import random
+import sys
+
+import dcghost
+
+print("Test05")
+print("Statistics of U, I and P vs. float, host build")
+
+
+def stat_value(raw, offset):
+    # the values are clipped to 0..0xffff, see StatValue()
+    return max(0, min(0xffff, raw + offset))
+
+
+def exact(samples, off_u, off_i, lsb_u, lsb_i):
+    chans = [[], [], []]
+    for raw_u, raw_i in samples:
+        u = stat_value(raw_u, off_u) * lsb_u
+        i = stat_value(raw_i, off_i) * lsb_i
+        chans[0].append(u)
+        chans[1].append(i)
+        chans[2].append(u * i)
+    return [[min(c), max(c), sum(c) / len(c), math.sqrt(sum(x * x for x in c) / len(c))] for c in chans]
+
+
+def feed(dcg, samples, count):
+    # 4 slots per pair: U is converted in the first two (MUX on U), stored in the fourth and paired with the
+    # last I. I is converted in the last two and stored in the second slot of the next pair.
+    mux = dcg.var(ctypes.c_uint8, "PORTC")
+    adc_u = dcg.var(ctypes.c_uint16, "host_adc_u")
+    adc_i = dcg.var(ctypes.c_uint16, "host_adc_i")
+    before = 1
+    while True:                             # sync: the next slot switches the MUX to U
+        dcg.slot()
+        now = (mux.value >> 6) & 1
+        if before == 0 and now == 0:
+            break
+        before = now
+    adc_i.value = samples[0][1]
+    for n in range(count):
+        adc_u.value = samples[n % len(samples)][0]
+        dcg.slot()
+        dcg.slot()
+        adc_i.value = samples[(n + 1) % len(samples)][1]
+        dcg.slot()
+        dcg.slot()
+
+
+rnd = random.Random(5)
+noise = [(rnd.randint(20000, 40000), rnd.randint(0, 65535)) for _ in range(250)]
+wide = [(rnd.randint(0, 65535), rnd.randint(0, 65535)) for _ in range(500)]
+
+names = ("U", "I", "P")
+failed = 0
+for name, window, period in (
+        ("dc full scale", 500, [(65000, 64000)]),
+        ("dc 10%", 500, [(6554, 6554)]),
+        ("noise", 500, noise),
+        ("sine", 1000, [(int(32768 + 30000 * math.sin(2 * math.pi * n / 200)),
+                         int(32768 + 30000 * math.cos(2 * math.pi * n / 200))) for n in range(200)]),
+        ("window 30000", 30000, wide)):
+    dcg = dcghost.load("DUAL_DAC")
+    dcg.lib.GetStat.restype = ctypes.c_float
+    dcg.lib.GetStat.argtypes = [ctypes.c_uint8]
+    dcg.lib.host_adc_offset_u.restype = ctypes.c_int16
+    dcg.lib.host_adc_offset_i.restype = ctypes.c_int16
+    dcg.set(0, 20.0)                        # 30V range
+    dcg.set(1, 1.0)                         # 2A range
+    dcg.set(143, window)
+    dcg.run_ms(50)
+    dcg.set(142, 0)
+    feed(dcg, period, 2 * window + len(period))
+    dcg.set(142, 1)
+
+    lsb_u = dcg.array(ctypes.c_float, "ADCLSBU", 2)[1]
+    lsb_i = dcg.array(ctypes.c_float, "ADCLSBI", 4)[3]
+    ref = exact(period, dcg.lib.host_adc_offset_u(1), dcg.lib.host_adc_offset_i(3), lsb_u, lsb_i)
+    full = (65535 * lsb_u, 65535 * lsb_i, 65535 * lsb_u * 65535 * lsb_i)
+    count = dcg.lib.GetStatCount()
+    for ch in range(3):
+        dcg.set(145, ch)
+        got = [dcg.lib.GetStat(what) for what in range(4)]
+        worst = max(abs(g - r) for g, r in zip(got, ref[ch])) / full[ch]
+        ok = worst <= (1e-3 if ch == 2 else 1e-4) and count == window
+        if not ok:
+            failed += 1
+        print("%-13s %s: %5d samples, max error %.6f%% of full scale  %s"
+              % (name, names[ch], count, worst * 100, "ok" if ok else "FAILED"))
+
+print("---------------------------------------")
+if failed:
+    print("%d runs failed" % failed)
+    sys.exit(1)
+print("all runs ok")
@@ -0,0 +1,93 @@
+#! /usr/bin/python
+
+#
+# Upload an arbitrary sequence into the RAM array of the DCG by block transfer (SubCh 193).
+#
+# Input file: one point per line, "voltage time", voltage 0.0..1.0 of dcv, time in ms (up to 273 h).
+# Several sequences can be separated by a time value of 0, like in the RAM array.
+#
+import argparse
+#
+import ctlab
+import ctlab_helper
+
+ARBINDEXMAXRAM = 150     # ATmega644/1284P, see --max
+
+# time units of the DCG arrays: bits 15..14 = unit, bits 13..0 = count
+ARBT_UNITS_MS = (1, 100, 1000, 60000)
+ARBT_COUNTMASK = 0x3fff
+
+
+def read_points(filename):
+    points = []
+    with open(filename) as f:
+        for line in f:
+            line = line.split('#')[0].strip()
+            if line:
+                v, t = line.replace(',', ' ').split()
+                points.append((float(v), int(t)))
+    return points
+
+
+def encode_time(t):
+    # finest unit which holds the time, like ArbTimeEncode() in dcg.c
+    if t <= 0:
+        return 0
+    for unit, ms in enumerate(ARBT_UNITS_MS):
+        count = (t + ms // 2) // ms
+        if count <= ARBT_COUNTMASK:
+            return (unit << 14) | max(count, 1)
+    return (3 << 14) | ARBT_COUNTMASK
+
+
+def block_frame(start, points):
+    # II  VVVV TTTT ...  CC, the sum of all bytes incl. CC is 0 (mod 256)
+    data = [start]
+    for v, t in points:
+        v = int(round(min(max(v, 0.0), 1.0) * 65535))
+        t = encode_time(t)
+        data += [v >> 8, v & 0xff, t >> 8, t & 0xff]
+    data.append(-sum(data) & 0xff)
+    return ''.join('%02X' % b for b in data)
+
+
+def upload(lab, points, per_frame):
+    lab.send_command(lab.dcg2, 'wen=1')
+    lab.send_command(lab.dcg2, '188=1')
+    for start in range(0, len(points), per_frame):
+        frame = block_frame(start, points[start:start + per_frame])
+        print('193=%s' % frame)
+        lab.send_command(lab.dcg2, '193=%s' % frame)
+    lab.send_command(lab.dcg2, 'wen=1')
+    lab.send_command(lab.dcg2, '188=2')
+
+
+def main():
+
+    print("Upload arbitrary sequence to DCG RAM array by block transfer")
+
+    # From Config-File
+    (serial_port, unic_config) = ctlab_helper.read_configfile('config.ini')
+    parser = argparse.ArgumentParser(description='Upload an arbitrary sequence into the RAM array.', prefix_chars='-')
+    parser.add_argument("-p", "--port", help="Used port nummer")
+    parser.add_argument("-f", "--file", required=True, help="Filename of the sequence, one 'voltage time' pair per line")
+    parser.add_argument("-m", "--max", type=int, default=ARBINDEXMAXRAM, help="Points of the RAM array: 150 (ATmega644/1284P), 75 (ATmega32)")
+    parser.add_argument("-n", "--points", type=int, default=4, help="Points per frame (1..8), limited by the input buffer of the DCG")
+    args = parser.parse_args()
+    if args.port is not None:
+        serial_port = args.port
+
+    points = read_points(args.file)
+    if len(points) > args.max:
+        print("too many points: %d, max. %d" % (len(points), args.max))
+        return
+    print('port =', serial_port)
+    print('points =', len(points))
+
+    lab = ctlab.ctlab(serial_port)
+    lab.check_devices(verbose=True)
+
+    upload(lab, points, min(max(args.points, 1), 8))
+
+
+main()
@@ -47,54 +47,56 @@ uint16_t GetADC(uint8_t Channel)
 
 
 
-void ShiftOut1257(uint16_t Value)
-{
-    uint8_t tmp;
-    uint8_t i;
-
-    PORTB |= (1<<PB0);                  // SCLK high
-    tmp = Value >> 8;                   // delay
-    PORTB |= (1<<PB4);                  // STRDC high
-
-
-
-    for (i = 0; i < 4; i++)
-    {
-        PORTB &= ~(1<<PB0);             // SCLK low
-        if (tmp & 0x08)
-        {
-            PORTB |= (1<<PB1);          // SDATA high
-        }
-        else
-        {
-            PORTB &= ~(1<<PB1);         // SDATA low
-        }
-        PORTB |= (1<<PB0);              // SCLK high
-        tmp <<= 1;
-    }
-
-    tmp = Value;
-    for (i = 0; i < 8; i++)
-    {
-        PORTB &= ~(1<<PB0);             // SCLK low
-        if (tmp & 0x80)
-        {
-            PORTB |= (1<<PB1);          // SDATA high
-        }
-        else
-        {
-            PORTB &= ~(1<<PB1);         // SDATA low
-        }
-        PORTB |= (1<<PB0);              // SCLK high
-        tmp <<= 1;
-    }
-
-    PORTB &= ~(1<<PB4);                 // STRDC low
-    tmp <<= 1;                          // Dummy als Delay
-    PORTB &= ~(1<<PB0);                 // SCLK low
-    tmp <<= 1;                          // Dummy als Delay
-    PORTB |= (1<<PB4);                  // STRDC high
-}
+//#if 0
+//void ShiftOut1257(uint16_t Value)
+//{
+//	uint8_t tmp;
+//	uint8_t i;
+//
+//	PORTB |= (1<<PB0);				  // SCLK high
+//	tmp = Value >> 8;				   // delay
+//	PORTB |= (1<<PB4);				  // STRDC high
+//
+//
+//
+//	for (i = 0; i < 4; i++)
+//	{
+//		PORTB &= ~(1<<PB0);			 // SCLK low
+//		if (tmp & 0x08)
+//		{
+//			PORTB |= (1<<PB1);		  // SDATA high
+//		}
+//		else
+//		{
+//			PORTB &= ~(1<<PB1);		 // SDATA low
+//		}
+//		PORTB |= (1<<PB0);			  // SCLK high
+//		tmp <<= 1;
+//	}
+//
+//	tmp = Value;
+//	for (i = 0; i < 8; i++)
+//	{
+//		PORTB &= ~(1<<PB0);			 // SCLK low
+//		if (tmp & 0x80)
+//		{
+//			PORTB |= (1<<PB1);		  // SDATA high
+//		}
+//		else
+//		{
+//			PORTB &= ~(1<<PB1);		 // SDATA low
+//		}
+//		PORTB |= (1<<PB0);			  // SCLK high
+//		tmp <<= 1;
+//	}
+//
+//	PORTB &= ~(1<<PB4);				 // STRDC low
+//	tmp <<= 1;						  // Dummy als Delay
+//	PORTB &= ~(1<<PB0);				 // SCLK low
+//	tmp <<= 1;						  // Dummy als Delay
+//	PORTB |= (1<<PB4);				  // STRDC high
+//}
+//#endif
 
 void LM75_Configure(float Temp)
 {
@@ -341,6 +341,15 @@ void ArbModeToString(char* str, uint8_t t)
         case 2:
             sprintf_P(str, PSTR("    RAM "));
             break;
+        case 3:
+            sprintf_P(str, PSTR(" Stream "));
+            break;
+        case 4:
+            sprintf_P(str, PSTR("   Func "));
+            break;
+        case 5:
+            sprintf_P(str, PSTR("Program "));
+            break;
     }
 }
 
@@ -548,19 +557,19 @@ void TemperatureToString(char* str, float i)
 void PanelPrintU(uint8_t cursor)
 {
     char line[9];
-    float* dptr;
+    float Value;
 
-    dptr = &xVoltage;
+    Value = GetVoltage();
 
     if (RippleActive)
     {
         if (ToggleDisplay)
         {
-            dptr = &xVoltageLow;
+            Value = GetVoltageLow();
         }
     }
 
-    FloatToString(line, *dptr, VOLT);
+    FloatToString(line, Value, VOLT);
 
     if (cursor != ' ')
     {
@@ -582,21 +591,21 @@ void PanelPrintU(uint8_t cursor)
 void PanelPrintI(uint8_t cursor)
 {
     char line[9];
-    float* dptr;
+    float Value;
 
     if (!PanelPrintFault(line))
     {
-        dptr = &xCurrent;
+        Value = GetCurrent();
 
         if (RippleActive)
         {
             if (ToggleDisplay)
             {
-                dptr = &xCurrentLow;
+                Value = GetCurrentLow();
             }
         }
 
-        FloatToString(line, *dptr, AMP );
+        FloatToString(line, Value, AMP );
 
         if (cursor != ' ')
         {
@@ -927,7 +936,7 @@ void jobPanel(void)
                         OutSubCh = 0;
                         unit = VOLT;
                     }
-                    else if (Modify == ModifyAmp)
+                    else            // ModifyAmp
                     {
                         pwValue = &wCurrent;
                         pModifyValuePos = &ModifyCurrentPos;
@@ -1978,7 +1987,7 @@ void jobPanel(void)
 
                     if (!PanelPrintFault(DisplayStr))
                     {
-                        FloatToString(DisplayStr, xPowerTot, WATT);
+                        FloatToString(DisplayStr, GetPowerTot(), WATT);
                     }
                     Lcd_Write(0, 1, 8, DisplayStr);
                     break;
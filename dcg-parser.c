@@ -19,8 +19,10 @@
 
 #include <inttypes.h>
 #include <avr/pgmspace.h>
+#include <util/atomic.h>
 
 #include <stdio.h>
+#include <string.h>
 
 #include "dcg.h"
 #include "Parser.h"
@@ -67,6 +69,7 @@ const PROGMEM char Mnemonics[][4] =
 #define PARAM_BYTE      2
 #define PARAM_STR       3
 #define PARAM_UINT16    4
+#define PARAM_LONG      5
 
 #define SCALE_NONE      0
 #define SCALE_A         1
@@ -141,6 +144,106 @@ int16_t GetADC4(void)
 }
 
 
+//---------------------------------------------------------------------------------------------
+
+int16_t GetBenchDAC(void)
+{
+    return Timer_BenchDAC();
+}
+
+
+//---------------------------------------------------------------------------------------------
+
+int16_t GetBenchLoad(void)
+{
+    return Timer_BenchLoad();
+}
+
+
+//---------------------------------------------------------------------------------------------
+
+int32_t GetProfMin(void)
+{
+    return Timer_ProfileGet(ProfSelect, PROF_MIN);
+}
+
+int32_t GetProfMax(void)
+{
+    return Timer_ProfileGet(ProfSelect, PROF_MAX);
+}
+
+int32_t GetProfMean(void)
+{
+    return Timer_ProfileGet(ProfSelect, PROF_MEAN);
+}
+
+int32_t GetProfRuns(void)
+{
+    return Timer_ProfileGet(ProfSelect, PROF_RUNS);
+}
+
+int32_t GetProfOverruns(void)
+{
+    return Timer_ProfileGet(ProfSelect, PROF_OVERRUNS);
+}
+
+
+//---------------------------------------------------------------------------------------------
+
+uint8_t GetCaptureState(void)
+{
+    return Timer_CaptureState();
+}
+
+int16_t GetCaptureCount(void)
+{
+    return Timer_CaptureCount();
+}
+
+int16_t GetCaptureTrigger(void)
+{
+    return Timer_CaptureTrigger();
+}
+
+int32_t GetCaptureTime(void)
+{
+    return Timer_CaptureTime();
+}
+
+int32_t GetTicker(void)
+{
+    return Timer_GetTicker();
+}
+
+
+//---------------------------------------------------------------------------------------------
+
+int32_t GetStatSamples(void)
+{
+    return GetStatCount();
+}
+
+float GetStatMin(void)
+{
+    return GetStat(STAT_MIN);
+}
+
+float GetStatMax(void)
+{
+    return GetStat(STAT_MAX);
+}
+
+float GetStatMean(void)
+{
+    return GetStat(STAT_MEAN);
+}
+
+float GetStatRms(void)
+{
+    return GetStat(STAT_RMS);
+}
+
+
 //---------------------------------------------------------------------------------------------
 
 void GetAll(PARAMTABLE* ParamTable __attribute__((unused)))
@@ -168,6 +271,207 @@ void ReturnIDN(PARAMTABLE* ParamTable __attribute__((unused)))
 }
 */
 
+//---------------------------------------------------------------------------------------------
+
+//*** Arbitrary block transfer, SubCh 193 ***
+// Frame after '=' in hex pairs:  II  VVVV TTTT  [VVVV TTTT ...]  CC
+//      II   = RAM array index of the first point
+//      VVVV = voltage 0000..FFFF = 0.0..1.0 of dcv
+//      TTTT = time, bits 15..14 = unit, bits 13..0 = count (see ARBT in dcg.h)
+//      CC   = checksum, the sum of all bytes of the frame incl. CC has to be 0 (mod 256)
+// The number of points per frame is limited by the input buffer of the parser.
+
+#define ARBBLOCKMAXPOINTS 8
+
+uint8_t ArbBlockIndex = 0;      // index after the last point loaded, read back by 193?
+
+static uint8_t HexToNibble(char c)
+{
+    if ((c >= '0') && (c <= '9'))
+        return c - '0';
+    if ((c >= 'A') && (c <= 'F'))
+        return c - 'A' + 10;
+    if ((c >= 'a') && (c <= 'f'))
+        return c - 'a' + 10;
+    return 0xff;
+}
+
+// converts the hex pairs after '=' of the input string into Frame and checks the checksum.
+// Returns the number of bytes incl. checksum, 0 in case of an error.
+static uint8_t ParseHexFrame(uint8_t* Frame, uint8_t Size)
+{
+    uint8_t Len = 0;
+    uint8_t Sum = 0;
+    uint8_t Hi, Lo;
+    const char* s = strchr(g_cSerInpStr, '=');
+
+    if (s == NULL)
+    {
+        return 0;
+    }
+
+    for (s++; (Hi = HexToNibble(s[0])) != 0xff; s += 2)
+    {
+        Lo = HexToNibble(s[1]);
+        if ((Lo == 0xff) || (Len >= Size))
+        {
+            return 0;
+        }
+        Frame[Len] = (Hi << 4) | Lo;
+        Sum += Frame[Len++];
+    }
+
+    return (Sum == 0) ? Len : 0;
+}
+
+static uint8_t ParseArbBlock(uint8_t* pIndex)
+{
+    uint8_t Frame[2 + 4 * ARBBLOCKMAXPOINTS];
+    uint8_t Len, Count, Start, i;
+    uint8_t* p;
+    uint16_t T;
+
+    Len = ParseHexFrame(Frame, sizeof(Frame));
+    if ((Len < 6) || ((Len - 2) % 4 != 0))
+    {
+        return 0;
+    }
+
+    Start = Frame[0];
+    Count = (Len - 2) / 4;
+    if (Start + Count > ARBINDEXMAXRAM)
+    {
+        return 0;
+    }
+
+    for (i = 0, p = &Frame[1]; i < Count; i++, p += 4)
+    {
+        ArbV_RAM[Start + i] = ((uint16_t)p[0] << 8) | p[1];
+        T = ((uint16_t)p[2] << 8) | p[3];
+        ArbT_RAM[Start + i] = (T & ARBT_COUNTMASK) ? T : 0;     // unit and count, see ARBT()
+    }
+
+    *pIndex = Start + Count;
+    return 1;
+}
+
+
+//*** Arbitrary program transfer, SubCh 116 ***
+// Frame after '=' in hex pairs:  II  OP AA VVVV TTTT  [OP AA VVVV TTTT ...]  CC
+//      II   = index of the first instruction
+//      OP   = ARBOP_xxx, AA = loop count/jump target, VVVV = voltage/current 0000..FFFF, TTTT = time in ms
+//      CC   = checksum as for SubCh 193
+
+#define ARBPRGFRAMEMAX 4
+
+uint8_t ArbPrgIndex = 0;        // index after the last instruction loaded, read back by 116?
+static uint8_t ProfReset;           // for Parameter 126, any value written resets the profiles
+static uint8_t CaptureCmd;          // for Parameter 128, CAPTURE_CMD_xxx
+static int16_t CaptureReadIndex;    // for Parameter 136, first sample of the next frame of 137
+static uint8_t StatCmd;             // for Parameter 142, STAT_CMD_xxx
+
+static uint8_t ParseArbProgram(void)
+{
+    uint8_t Frame[2 + 6 * ARBPRGFRAMEMAX];
+    uint8_t Len, Count, Start, i;
+    uint8_t Op, Depth;
+    uint8_t* p;
+
+    Len = ParseHexFrame(Frame, sizeof(Frame));
+    if ((Len < 8) || ((Len - 2) % 6 != 0))
+    {
+        return 0;
+    }
+
+    Start = Frame[0];
+    Count = (Len - 2) / 6;
+    if (Start + Count > ARBPRGMAX)
+    {
+        return 0;
+    }
+
+    // loops nested deeper than the stack of the ISR: the frame is rejected, the program is left as it was
+    for (i = 0, Depth = 0; i < ARBPRGMAX; i++)
+    {
+        Op = ((i >= Start) && (i < Start + Count)) ? Frame[1 + 6 * (i - Start)] : ArbPrg[i].Op;
+        if (Op == ARBOP_LOOP)
+        {
+            if (++Depth > ARBPRGLOOPS)
+            {
+                return 0;
+            }
+        }
+        else if ((Op == ARBOP_NEXT) && (Depth > 0))
+        {
+            Depth--;
+        }
+    }
+
+    for (i = 0, p = &Frame[1]; i < Count; i++, p += 6)
+    {
+        ArbPrg[Start + i].Op  = p[0];
+        ArbPrg[Start + i].Arg = p[1];
+        ArbPrg[Start + i].V   = ((uint16_t)p[2] << 8) | p[3];
+        ArbPrg[Start + i].T   = ((uint16_t)p[4] << 8) | p[5];
+    }
+
+    ArbPrgIndex = Start + Count;
+    return 1;
+}
+
+
+//*** Capture transfer, SubCh 137 ***
+// Answer after '=' in hex pairs:  NNNN  UUUU IIII  [UUUU IIII ...]  CC
+//      NNNN = index of the first sample in the record, the trigger is at sample 135?
+//      UUUU = raw ADC value of U, IIII = of I
+//      CC   = checksum as for SubCh 193
+// Each read continues after the last sample, the frame after the last one holds NNNN and CC only.
+
+#define CAPTUREFRAMESAMPLES 16
+
+void GetCaptureFrame(PARAMTABLE* ParamTable)
+{
+    uint16_t U, I;
+    uint8_t Sum, n;
+
+    printf_P(PSTR("#%d:%d=%04X"), g_ucSlaveCh, ParamTable->SubCh, CaptureReadIndex);
+    Sum = (CaptureReadIndex >> 8) + CaptureReadIndex;
+    for (n = 0; (n < CAPTUREFRAMESAMPLES) && Timer_CaptureRead(CaptureReadIndex, &U, &I); n++)
+    {
+        printf_P(PSTR("%04X%04X"), U, I);
+        Sum += (U >> 8) + U + (I >> 8) + I;
+        CaptureReadIndex++;
+    }
+    printf_P(PSTR("%02X\n"), (uint8_t)-Sum);
+}
+
+
+//*** Telemetry record, SubCh 220, sent by jobTelemetry or read ***
+// Answer after '=' in hex pairs:  NN  UUUUUUUU IIIIIIII PPPPPPPP  SS  CC
+//      NN = number of the record, counts the records of jobTelemetry
+//      UUUUUUUU = U in uV, IIIIIIII = I in 10nA, PPPPPPPP = P in uW, as int32 of jobGetValues
+//      SS = status as for 255, CC = checksum as for SubCh 193
+
+void GetTeleRecord(PARAMTABLE* ParamTable)
+{
+    int32_t Values[3];
+    uint8_t Sum, i;
+
+    Values[0] = xVoltage_uV;
+    Values[1] = xCurrent_10nA;
+    Values[2] = GetPower() * 1e6;
+
+    printf_P(PSTR("#%d:%d=%02X"), g_ucSlaveCh, ParamTable->SubCh, TeleSeq);
+    Sum = TeleSeq + Status.u8;
+    for (i = 0; i < 3; i++)
+    {
+        printf_P(PSTR("%08lX"), Values[i]);
+        Sum += (Values[i] >> 24) + (Values[i] >> 16) + (Values[i] >> 8) + Values[i];
+    }
+    printf_P(PSTR("%02X%02X\n"), Status.u8, (uint8_t)-Sum);
+}
+
+
 //---------------------------------------------------------------------------------------------
 
 const PROGMEM PARAMTABLE SetParamTable[] =
@@ -179,14 +483,14 @@ const PROGMEM PARAMTABLE SetParamTable[] =
     {.SubCh = 3,   .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_uA,   .u.s = {.ram.f = &wCurrent, .eep.f = (float*)-1}},
     {.SubCh = 7,   .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &xAmpHours, .eep.f = (float*)-1}},
     {.SubCh = 8,   .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &xWattHours,.eep.f = (float*)-1}},
-    {.SubCh = 10,  .rw = 0, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &xVoltage, .eep.f = (float*)-1}},
-    {.SubCh = 11,  .rw = 0, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_A,    .u.s = {.ram.f = &xCurrent, .eep.f = (float*)-1}},
-    {.SubCh = 12,  .rw = 0, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_mA,   .u.s = {.ram.f = &xCurrent, .eep.f = (float*)-1}},
-    {.SubCh = 13,  .rw = 0, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_uA,   .u.s = {.ram.f = &xCurrent, .eep.f = (float*)-1}},
+    {.SubCh = 10,  .rw = 0, .fct = 1, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.get_f_Function = GetVoltage},
+    {.SubCh = 11,  .rw = 0, .fct = 1, .type = PARAM_FLOAT,  .scale = SCALE_A,    .u.get_f_Function = GetCurrent},
+    {.SubCh = 12,  .rw = 0, .fct = 1, .type = PARAM_FLOAT,  .scale = SCALE_mA,   .u.get_f_Function = GetCurrent},
+    {.SubCh = 13,  .rw = 0, .fct = 1, .type = PARAM_FLOAT,  .scale = SCALE_uA,   .u.get_f_Function = GetCurrent},
     {.SubCh = 15,  .rw = 0, .fct = 1, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.get_f_Function = GetPowerIn},
-    {.SubCh = 16,  .rw = 0, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &xMeanVoltage, .eep.f = (float*)-1}},
-    {.SubCh = 17,  .rw = 0, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_A,    .u.s = {.ram.f = &xMeanCurrent, .eep.f = (float*)-1}},
-    {.SubCh = 18,  .rw = 0, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &xPower, .eep.f = (float*)-1}},
+    {.SubCh = 16,  .rw = 0, .fct = 1, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.get_f_Function = GetMeanVoltage},
+    {.SubCh = 17,  .rw = 0, .fct = 1, .type = PARAM_FLOAT,  .scale = SCALE_A,    .u.get_f_Function = GetMeanCurrent},
+    {.SubCh = 18,  .rw = 0, .fct = 1, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.get_f_Function = GetPower},
     {.SubCh = 20,  .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_PROZ, .u.s = {.ram.f = &DCVoltMod,  .eep.f = (float*)-1}},
     {.SubCh = 21,  .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_PROZ, .u.s = {.ram.f = &DCAmpMod,   .eep.f = (float*)-1}},
     {.SubCh = 27,  .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &Params.RippleOn,  .eep.i = (int16_t*)-1}},
@@ -198,6 +502,19 @@ const PROGMEM PARAMTABLE SetParamTable[] =
     {.SubCh = 52,  .rw = 0, .fct = 1, .type = PARAM_INT,    .scale = SCALE_NONE, .u.get_i_Function = GetADC2},
     {.SubCh = 53,  .rw = 0, .fct = 1, .type = PARAM_INT,    .scale = SCALE_NONE, .u.get_i_Function = GetADC3},
     {.SubCh = 54,  .rw = 0, .fct = 1, .type = PARAM_INT,    .scale = SCALE_NONE, .u.get_i_Function = GetADC4},
+    {.SubCh = 55,  .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &ADCSamples, .eep.b = (uint8_t*)-1}},
+    {.SubCh = 56,  .rw = 0, .fct = 1, .type = PARAM_INT,    .scale = SCALE_NONE, .u.get_i_Function = GetBenchDAC},
+    {.SubCh = 57,  .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &SHRefresh, .eep.b = (uint8_t*)-1}},
+    {.SubCh = 58,  .rw = 0, .fct = 0, .type = PARAM_UINT16, .scale = SCALE_NONE, .u.s.ram.u = &DACSkipped},
+    {.SubCh = 59,  .rw = 0, .fct = 1, .type = PARAM_INT,    .scale = SCALE_NONE, .u.get_i_Function = GetBenchLoad},
+    {.SubCh = 60,  .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &SchedLatencyMax[0], .eep.i = (int16_t*)-1}},
+    {.SubCh = 61,  .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &SchedLatencyMax[1], .eep.i = (int16_t*)-1}},
+    {.SubCh = 62,  .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &SchedLatencyMax[2], .eep.i = (int16_t*)-1}},
+    {.SubCh = 63,  .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &SchedLatencyMax[3], .eep.i = (int16_t*)-1}},
+    {.SubCh = 64,  .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &SchedOverruns[0], .eep.i = (int16_t*)-1}},
+    {.SubCh = 65,  .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &SchedOverruns[1], .eep.i = (int16_t*)-1}},
+    {.SubCh = 66,  .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &SchedOverruns[2], .eep.i = (int16_t*)-1}},
+    {.SubCh = 67,  .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &SchedOverruns[3], .eep.i = (int16_t*)-1}},
     {.SubCh = 70,  .rw = 0, .fct = 0, .type = PARAM_UINT16, .scale = SCALE_NONE, .u.s.ram.u = &DACRawU},
     {.SubCh = 71,  .rw = 0, .fct = 0, .type = PARAM_UINT16, .scale = SCALE_NONE, .u.s.ram.u = &DACRawI},
     {.SubCh = 89,  .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &Params.ucEncoderPrescaler, .eep.b = &eepParams.ucEncoderPrescaler}},
@@ -214,6 +531,39 @@ const PROGMEM PARAMTABLE SetParamTable[] =
     {.SubCh = 113, .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &Params.ADCIOffsets[1], .eep.i = &eepParams.ADCIOffsets[1]}},
     {.SubCh = 114, .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &Params.ADCIOffsets[2], .eep.i = &eepParams.ADCIOffsets[2]}},
     {.SubCh = 115, .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &Params.ADCIOffsets[3], .eep.i = &eepParams.ADCIOffsets[3]}},
+    {.SubCh = 116, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &ArbPrgIndex,   .eep.b = (uint8_t*)-1}},
+    {.SubCh = 117, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &ArbPrgTrigger, .eep.b = (uint8_t*)-1}},
+    {.SubCh = 118, .rw = 0, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s.ram.b = &ArbPrgPC},
+    {.SubCh = 120, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &ProfSelect, .eep.b = (uint8_t*)-1}},
+    {.SubCh = 121, .rw = 0, .fct = 1, .type = PARAM_LONG,   .scale = SCALE_NONE, .u.get_l_Function = GetProfMin},
+    {.SubCh = 122, .rw = 0, .fct = 1, .type = PARAM_LONG,   .scale = SCALE_NONE, .u.get_l_Function = GetProfMax},
+    {.SubCh = 123, .rw = 0, .fct = 1, .type = PARAM_LONG,   .scale = SCALE_NONE, .u.get_l_Function = GetProfMean},
+    {.SubCh = 124, .rw = 0, .fct = 1, .type = PARAM_LONG,   .scale = SCALE_NONE, .u.get_l_Function = GetProfRuns},
+    {.SubCh = 125, .rw = 0, .fct = 1, .type = PARAM_LONG,   .scale = SCALE_NONE, .u.get_l_Function = GetProfOverruns},
+    {.SubCh = 126, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &ProfReset, .eep.b = (uint8_t*)-1}},
+    {.SubCh = 127, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &WaveTicks, .eep.b = (uint8_t*)-1}},
+    {.SubCh = 128, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &CaptureCmd, .eep.b = (uint8_t*)-1}},
+    {.SubCh = 129, .rw = 0, .fct = 1, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.get_b_Function = GetCaptureState},
+    {.SubCh = 130, .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &CapturePre, .eep.i = (int16_t*)-1}},
+    {.SubCh = 131, .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &CapturePost, .eep.i = (int16_t*)-1}},
+    {.SubCh = 132, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &CaptureDecimation, .eep.b = (uint8_t*)-1}},
+    {.SubCh = 133, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &CaptureSource, .eep.b = (uint8_t*)-1}},
+    {.SubCh = 134, .rw = 0, .fct = 1, .type = PARAM_INT,    .scale = SCALE_NONE, .u.get_i_Function = GetCaptureCount},
+    {.SubCh = 135, .rw = 0, .fct = 1, .type = PARAM_INT,    .scale = SCALE_NONE, .u.get_i_Function = GetCaptureTrigger},
+    {.SubCh = 136, .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &CaptureReadIndex, .eep.i = (int16_t*)-1}},
+    {.SubCh = 137, .rw = 0, .fct = 2, .type = PARAM_STR,    .scale = SCALE_NONE, .u.doFunction = GetCaptureFrame},
+    {.SubCh = 138, .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &CaptureLevel, .eep.f = (float*)-1}},
+    {.SubCh = 139, .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &CaptureLevelHigh, .eep.f = (float*)-1}},
+    {.SubCh = 140, .rw = 0, .fct = 1, .type = PARAM_LONG,   .scale = SCALE_NONE, .u.get_l_Function = GetCaptureTime},
+    {.SubCh = 141, .rw = 0, .fct = 1, .type = PARAM_LONG,   .scale = SCALE_NONE, .u.get_l_Function = GetTicker},
+    {.SubCh = 142, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &StatCmd, .eep.b = (uint8_t*)-1}},
+    {.SubCh = 143, .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &StatWindow, .eep.i = (int16_t*)-1}},
+    {.SubCh = 144, .rw = 0, .fct = 1, .type = PARAM_LONG,   .scale = SCALE_NONE, .u.get_l_Function = GetStatSamples},
+    {.SubCh = 145, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &StatSelect, .eep.b = (uint8_t*)-1}},
+    {.SubCh = 146, .rw = 0, .fct = 1, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.get_f_Function = GetStatMin},
+    {.SubCh = 147, .rw = 0, .fct = 1, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.get_f_Function = GetStatMax},
+    {.SubCh = 148, .rw = 0, .fct = 1, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.get_f_Function = GetStatMean},
+    {.SubCh = 149, .rw = 0, .fct = 1, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.get_f_Function = GetStatRms},
     {.SubCh = 150, .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &Params.InitVoltage, .eep.f = &eepParams.InitVoltage}},
     {.SubCh = 151, .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &Params.InitCurrent, .eep.f = &eepParams.InitCurrent}},
     {.SubCh = 152, .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &Params.GainPre, .eep.f = &eepParams.GainPre}},
@@ -239,6 +589,9 @@ const PROGMEM PARAMTABLE SetParamTable[] =
     {.SubCh = 173, .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &Params.RippleOff, .eep.i = &eepParams.RippleOff}},
     {.SubCh = 174, .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &Params.RippleMod, .eep.i = &eepParams.RippleMod}},
     {.SubCh = 175, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &Params.OutputOnOff, .eep.b = &eepParams.OutputOnOff}},
+    {.SubCh = 176, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &ArbTarget,  .eep.b = (uint8_t*)-1}},
+    {.SubCh = 177, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &ArbSelectI, .eep.b = (uint8_t*)-1}},
+    {.SubCh = 178, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &ArbRAMtmpTUnit, .eep.b = (uint8_t*)-1}},
 
     {.SubCh = 180, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &ActiveParamSet, .eep.b = (uint8_t*)-1}},
     {.SubCh = 181, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &wStartParamSet, .eep.b = &StartParamSet}},
@@ -252,6 +605,16 @@ const PROGMEM PARAMTABLE SetParamTable[] =
     {.SubCh = 187, .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.u = &ArbRAMtmpT, .eep.u = (uint16_t*)-1}},
     {.SubCh = 188, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &ArbUpdateMode, .eep.b = (uint8_t*)-1}},
     {.SubCh = 189, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &ArbSelectRAM,  .eep.b = (uint8_t*)-1}},
+    {.SubCh = 190, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &ArbSwapMode,   .eep.b = (uint8_t*)-1}},
+    {.SubCh = 191, .rw = 0, .fct = 1, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.get_b_Function = GetArbStreamLevel},
+    {.SubCh = 192, .rw = 0, .fct = 0, .type = PARAM_UINT16, .scale = SCALE_NONE, .u.s.ram.u = &ArbStreamUnderrun},
+    {.SubCh = 193, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &ArbBlockIndex, .eep.b = (uint8_t*)-1}},
+    {.SubCh = 194, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &ArbFuncShape,  .eep.b = (uint8_t*)-1}},
+    {.SubCh = 195, .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &ArbFuncFreq,   .eep.f = (float*)-1}},
+    {.SubCh = 196, .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &ArbFuncAmp,    .eep.f = (float*)-1}},
+    {.SubCh = 197, .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &ArbFuncOffset, .eep.f = (float*)-1}},
+    {.SubCh = 198, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &ArbFuncDuty,   .eep.b = (uint8_t*)-1}},
+    {.SubCh = 199, .rw = 0, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s.ram.b = &ArbDirCount},
 
     {.SubCh = 200, .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &Params.DACUScales[0], .eep.f = &eepParams.DACUScales[0]}},
     {.SubCh = 201, .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &Params.DACUScales[1], .eep.f = &eepParams.DACUScales[1]}},
@@ -265,6 +628,11 @@ const PROGMEM PARAMTABLE SetParamTable[] =
     {.SubCh = 213, .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &Params.ADCIScales[1], .eep.f = &eepParams.ADCIScales[1]}},
     {.SubCh = 214, .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &Params.ADCIScales[2], .eep.f = &eepParams.ADCIScales[2]}},
     {.SubCh = 215, .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &Params.ADCIScales[3], .eep.f = &eepParams.ADCIScales[3]}},
+    {.SubCh = 216, .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &TeleInterval, .eep.i = (int16_t*)-1}},
+    {.SubCh = 217, .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.i = &TeleOffset, .eep.i = (int16_t*)-1}},
+    {.SubCh = 218, .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &TeleDeadbandU, .eep.f = (float*)-1}},
+    {.SubCh = 219, .rw = 1, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_NONE, .u.s = {.ram.f = &TeleDeadbandI, .eep.f = (float*)-1}},
+    {.SubCh = 220, .rw = 0, .fct = 2, .type = PARAM_STR,    .scale = SCALE_NONE, .u.doFunction = GetTeleRecord},
     {.SubCh = 233, .rw = 0, .fct = 0, .type = PARAM_FLOAT,  .scale = SCALE_TEMP, .u.s = {.ram.f = &Temperature}},
     {.SubCh = 251, .rw = 1, .fct = 0, .type = PARAM_INT,    .scale = SCALE_NONE, .u.s = {.ram.u = &g_ucErrCount, .eep.u = (uint16_t*)-1}},
     {.SubCh = 252, .rw = 1, .fct = 0, .type = PARAM_BYTE,   .scale = SCALE_NONE, .u.s = {.ram.b = &Params.SerBaudReg, .eep.b = &eepParams.SerBaudReg}},
@@ -324,6 +692,7 @@ void ParseGetParam(uint8_t SubCh)
         const char* s;
     } Data;
 
+    TeleCommand();
     if (SubCh == 255)
     {
         SerPrompt(NoErr, Status.u8);
@@ -361,6 +730,10 @@ void ParseGetParam(uint8_t SubCh)
                 Data.u = ParamData.u.get_u_Function();
                 break;
 
+            case PARAM_LONG:
+                Data.l = ParamData.u.get_l_Function();
+                break;
+
             case PARAM_BYTE:
                 Data.b = ParamData.u.get_b_Function();
                 break;
@@ -388,6 +761,10 @@ void ParseGetParam(uint8_t SubCh)
                 Data.u = *ParamData.u.s.ram.u;
                 break;
 
+            case PARAM_LONG:
+                Data.l = *ParamData.u.s.ram.l;
+                break;
+
             case PARAM_BYTE:
                 Data.b = *ParamData.u.s.ram.b;
                 break;
@@ -445,6 +822,10 @@ void ParseGetParam(uint8_t SubCh)
             printf_P(PSTR("#%d:%d=%u\n"), g_ucSlaveCh, SubCh, Data.u);
             break;
 
+        case PARAM_LONG:
+            printf_P(PSTR("#%d:%d=%ld\n"), g_ucSlaveCh, SubCh, Data.l);
+            break;
+
         case PARAM_BYTE:
             printf_P(PSTR("#%d:%d=%u\n"), g_ucSlaveCh, SubCh, Data.b);
             break;
@@ -463,11 +844,14 @@ void ParseSetParam(uint8_t SubCh, float Param)
 {
     uint8_t tmpActiveParamSet = ActiveParamSet;
     uint8_t tmpwStartParamSet = wStartParamSet;
+    uint8_t tmpArbPrgIndex = ArbPrgIndex;
+    uint16_t tmpArbT;
 
     static uint8_t ArbIndex = 0;
     static uint8_t ArbIndicator = 0;
     static uint8_t oldArbUpdateMode = 0;
 
+    TeleCommand();
     if (Status.Busy)
     {
         SerPrompt(BusyErr, 0);
@@ -493,6 +877,12 @@ void ParseSetParam(uint8_t SubCh, float Param)
             return;
         }
 
+        if ((SubCh >= 60) && (SubCh <= 67) && (Param != 0))     // scheduling statistics: 0 resets, nothing else
+        {
+            SerPrompt(ParamErr, 0);
+            return;
+        }
+
         switch(Data.type)
         {
             case PARAM_FLOAT:
@@ -523,7 +913,10 @@ void ParseSetParam(uint8_t SubCh, float Param)
                 break;
 
             case PARAM_INT:
-                *Data.u.s.ram.i = (int16_t)Param;
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE)   // the ISR counts SchedOverruns
+                {
+                    *Data.u.s.ram.i = (int16_t)Param;
+                }
                 break;
 
         }
@@ -563,6 +956,33 @@ void ParseSetParam(uint8_t SubCh, float Param)
             InitScales();
 
         }
+        else if (SubCh == 126)          // reset of the profiles, any value
+        {
+            Timer_ProfileReset();
+        }
+        else if (SubCh == 128)          // capture: stop, arm or trigger
+        {
+            CaptureCalcLevels();
+            Timer_CaptureControl(CaptureCmd);
+            if (CaptureCmd == CAPTURE_CMD_ARM)
+            {
+                CaptureReadIndex = 0;
+            }
+        }
+        else if (SubCh == 142)          // statistics: restart, snapshot or both
+        {
+            StatSnapshot(StatCmd);
+        }
+        else if (SubCh == 143)          // window of the statistics, restarts them
+        {
+            LIMIT_INT16(&StatWindow, 0, STAT_WINDOWMAX);
+            StatRestart(1);
+        }
+        else if ((SubCh == 216) || (SubCh == 217))  // telemetry: the first record an interval after the slot
+        {
+            CheckLimits();
+            TeleSync();
+        }
         else if (SubCh == 180)          // ActiveParamSet
         {
 
@@ -603,7 +1023,7 @@ void ParseSetParam(uint8_t SubCh, float Param)
         else if ( (SubCh == 186) && (ArbUpdateMode == 1) )  // store Arbitrary Data to RAM Voltage array.
         {
             LIMIT_FLOAT(&ArbRAMtmpV, 0.0, 1.0);
-            ArbV_RAM[ArbIndex] = ArbRAMtmpV;
+            ArbV_RAM[ArbIndex] = ARBV(ArbRAMtmpV);
             ArbIndicator = 1;                               // indicator, that voltage value has been written to RAM
         }
 
@@ -613,11 +1033,12 @@ void ParseSetParam(uint8_t SubCh, float Param)
         {
             if (ArbIndicator != 1)
             {
-                ArbV_RAM[ArbIndex] = 1.0;                   // use default value, since no voltage value was set before this time value
+                ArbV_RAM[ArbIndex] = ARBV(1.0);             // use default value, since no voltage value was set before this time value
             }
 
             LIMIT_UINT16(&ArbRAMtmpT, 0, 65000);
-            ArbT_RAM[ArbIndex] = ArbRAMtmpT;
+            tmpArbT = ArbTimeEncode(ArbRAMtmpT, ArbRAMtmpTUnit);
+            ArbT_RAM[ArbIndex] = tmpArbT;
 
             ArbIndicator = 0;                               // indicator, that voltage/time value pair has been written to RAM
 
@@ -625,6 +1046,77 @@ void ParseSetParam(uint8_t SubCh, float Param)
             {
                 ArbIndex++;
             }
+            ArbRAMtmpT = ArbTimeMs(tmpArbT) / ArbUnitMs[ArbRAMtmpTUnit];  // time as stored, a multiple of the unit, read back by 187?
+        }
+
+//*** Arbitrary Program Load = 116 ***************************************
+
+        else if ( SubCh == 116 )        // store instructions of the program
+        {
+            Status.EEUnlocked = 0;
+
+            if ( ArbActive == 5 )       // the program must not be changed while it is running
+            {
+                ArbPrgIndex = tmpArbPrgIndex;
+                SerPrompt(BusyErr, 0);
+                return;
+            }
+            if ( !ParseArbProgram() )
+            {
+                ArbPrgIndex = tmpArbPrgIndex;
+                SerPrompt(ParamErr, 0);
+                return;
+            }
+
+            SerPrompt(NoErr, Status.u8);
+            return;                     // linked by SetLevelDAC when the program is started (182 = 5)
+        }
+
+//*** Arbitrary Block Load = 193 *****************************************
+
+        else if ( SubCh == 193 )        // store several points at once to the RAM arrays
+        {
+            Status.EEUnlocked = 0;
+
+            if ( (ArbUpdateMode != 1) || !ParseArbBlock(&ArbIndex) )
+            {
+                ArbBlockIndex = ArbIndex;
+                SerPrompt(ParamErr, 0);
+                return;
+            }
+            ArbBlockIndex = ArbIndex;
+            ArbIndicator = 0;
+
+            SerPrompt(NoErr, Status.u8);
+            return;                     // no recalculation per frame, done once by the finalisation (188 = 2)
+        }
+
+//*** Arbitrary Stream Voltage Value = 186 *******************************
+
+        else if ( (SubCh == 186) && (ArbUpdateMode == 5) )  // keep voltage value for the next point of the stream
+        {
+            LIMIT_FLOAT(&ArbRAMtmpV, 0.0, 1.0);
+            ArbIndicator = 1;
+        }
+
+//*** Arbitrary Stream Time Value = 187 **********************************
+
+        else if ( ( SubCh == 187) && (ArbUpdateMode == 5) ) // append the point to the stream
+        {
+            LIMIT_UINT16(&ArbRAMtmpT, 0, 65000);
+
+            if (!ArbStreamPut((ArbIndicator == 1) ? ArbRAMtmpV : 1.0, ArbRAMtmpT))
+            {
+                Status.EEUnlocked = 0;
+                SerPrompt(BusyErr, 0);                      // ring buffer full, point has to be sent again
+                return;
+            }
+            ArbIndicator = 0;
+
+            if (ArbRAMtmpT == 0)                            // end of stream
+            {
+                ArbUpdateMode = oldArbUpdateMode = 0;
+            }
         }
 
 //*** Arbitrary 188 ******************************************************
@@ -640,7 +1132,7 @@ void ParseSetParam(uint8_t SubCh, float Param)
                 if ( (oldArbUpdateMode == 0) && (ArbUpdateMode == 1))
                 {
                     oldArbUpdateMode = ArbUpdateMode;
-                    ArbIndex = 0;
+                    ArbIndex = ArbBlockIndex = 0;
                     ArbIndicator = 0;
                 }
 
@@ -663,12 +1155,13 @@ void ParseSetParam(uint8_t SubCh, float Param)
 
                     while ( ArbIndex < ARBINDEXMAXRAM )
                     {
-                        ArbV_RAM[ArbIndex] = 1.0;       // load the rest of the array with default value.
+                        ArbV_RAM[ArbIndex] = ARBV(1.0); // load the rest of the array with default value.
                         ArbT_RAM[ArbIndex] = 0;
                         ArbIndex++;
                     }
                     ArbIndex = 0;
                     ArbIndicator = 0;
+                    ArbDirBuild();                                              // RAM array has changed
                     ArbRAMOffset = get_SequenceStart_RAMarray(&ArbSelectRAM); // has to be called explicitly here because RAM array has chnaged
                     ArbUpdateMode = oldArbUpdateMode = 0;
                 }
@@ -678,8 +1171,7 @@ void ParseSetParam(uint8_t SubCh, float Param)
 
                 else if ( (oldArbUpdateMode == 0) && (ArbUpdateMode == 3))
                 {
-                    eeprom_write_block(ArbV_RAM, ArbV_EEP, sizeof(ArbV_RAM));
-                    eeprom_write_block(ArbT_RAM, ArbT_EEP, sizeof(ArbT_RAM));
+                    ArbSave_EEP();
 
                     ArbUpdateMode = oldArbUpdateMode = 0;
                 }
@@ -689,10 +1181,24 @@ void ParseSetParam(uint8_t SubCh, float Param)
 
                 else if ( (oldArbUpdateMode == 0) && (ArbUpdateMode == 4))
                 {
-                    eeprom_read_block(ArbV_RAM, ArbV_EEP, sizeof(ArbV_RAM));
-                    eeprom_read_block(ArbT_RAM, ArbT_EEP, sizeof(ArbT_RAM));
-
                     ArbUpdateMode = oldArbUpdateMode = 0;
+
+                    if (!ArbRecall_EEP())
+                    {
+                        Status.EEUnlocked = 0;
+                        SerPrompt(ParamErr, 0);                 // saved by an older firmware, the RAM array is kept
+                        return;
+                    }
+                }
+
+                //*** ArbUpdateMode = 5 **************************************
+                //*** Begin of Streaming, (re)start with an empty ring buffer ***
+
+                else if ( ((oldArbUpdateMode == 0) || (oldArbUpdateMode == 5)) && (ArbUpdateMode == 5))
+                {
+                    ArbStreamReset();
+                    oldArbUpdateMode = ArbUpdateMode;
+                    ArbIndicator = 0;
                 }
 
                 //*** ArbUpdateMode = unknown ********************************
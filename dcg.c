@@ -29,6 +29,8 @@
 #include <util/delay.h>
 
 #include <string.h>
+#include <stdlib.h>
+#include <math.h>
 
 #include "config.h"
 #include "Uart.h"
@@ -180,6 +182,19 @@ uint16_t ADCRawU;
 uint16_t ADCRawULow;
 uint16_t ADCRawI;
 uint16_t ADCRawILow;
+uint8_t  ADCSamples = 4;    // for Parameter 55, samples of the LTC1864 per value: 2, 4 or 8
+uint8_t  SHRefresh = 1;     // for Parameter 57, single DAC: a static S&H is refreshed in every n-th slot of its channel
+                            // (values > 1 lengthen the hold time, use them only after measuring the droop of the S&H)
+uint16_t DACSkipped;        // for Parameter 58, DAC updates skipped in the last second
+float    CaptureLevel;      // for Parameter 138, level of the threshold trigger in V or A, lower level of the window
+float    CaptureLevelHigh;  // for Parameter 139, upper level of the window trigger
+uint8_t  WaveTicks = 1;     // for Parameter 127, DUAL_DAC: ticks of the waveform per ms (1, 2, 4, 8), the times stay in ms
+uint8_t  StatSelect;        // for Parameter 145, STAT_U, STAT_I or STAT_P of the values 146..149
+int16_t  TeleInterval;      // for Parameter 216, ms between the telemetry records, 0 = off
+int16_t  TeleOffset;        // for Parameter 217, ms from the sync to the slot of the records, default by the address
+float    TeleDeadbandU;     // for Parameter 218, V, a record only if U or I changed more (0 and 0: every interval)
+float    TeleDeadbandI;     // for Parameter 219, A
+uint8_t  TeleSeq;           // number of the last record, 220
 
 uint16_t DACRawU;
 uint16_t DACRawI;
@@ -197,17 +212,18 @@ float ADCLSBU[2];
 float DACLSBI[4];
 float ADCLSBI[4];
 float PwrInFac;
-float xVoltage;
-float xVoltageLow;
-float xCurrent;
-float xCurrentLow;
-float xPower = 0.0;
-float xPowerTot = 0.0;
+int32_t xVoltage_uV;        // measured by jobGetValues, converted to float by GetVoltage() etc.
+int32_t xVoltageLow_uV;
+int32_t xCurrent_10nA;
+int32_t xCurrentLow_10nA;
+uint32_t ADCMulU[2];        // uV per LSB of a 16 bit value in 16.16 fixed point, set by InitScales
+uint32_t ADCMulI[4];        // 10nA per LSB, 2.67A full scale of the 2A range don't fit into nA
+uint8_t ADCRawShift;        // to a 16 bit value, 6 for the internal 10 bit ADC
 float xAmpHours = 0.0;
 float xWattHours = 0.0;
 
-float xMeanVoltage = 0.0;
-float xMeanCurrent = 0.0;
+int32_t xMeanVoltage_uV = 0;
+int32_t xMeanCurrent_10nA = 0;
 
 float DCVoltMod;
 float DCAmpMod;
@@ -226,7 +242,7 @@ uint16_t RippleActive = 0;
 
 // variables for operation, currently not stored EEPROM
 uint8_t ArbActive = 0;      // for Parameter 182
-                            // 0 = off , 1 = ROM, 2 = RAM   // ArbActive must be off for boot sequence, to avoid unwanted voltages at the output
+                            // 0 = off , 1 = ROM, 2 = RAM, 3 = Stream, 4 = Function generator, 5 = Program   // ArbActive must be off for boot sequence, to avoid unwanted voltages at the output
 #define ARBACTIVESTART 0
 
 uint8_t ArbSelect = 0;      // for Parameter 183
@@ -242,16 +258,44 @@ float ArbRAMtmpV = 0.0;    // for Parameter 186 = Loading Voltage values into ar
 
 uint16_t ArbRAMtmpT = 0;    // for Parameter 187 = Loading Time values into array one-by-one
 
+uint8_t ArbRAMtmpTUnit = ARBT_UNIT_MS;  // for Parameter 178 = unit of the time values of Parameter 187 (RAM array only)
+                            // 0 = ms, 1 = 100 ms, 2 = s, 3 = min
+
 uint8_t ArbUpdateMode = 0;  // for Parameter 188 = Selection of Arbitrary RAM mode handling
                             // 0 = normal Arb operation,
                             // 1 = Loading values (Arb disabled), by parameters 186+187, repeatedly
                             // 2 = Finalizing loading of values: filling rest of memory with default data, falling back to Mode 0
                             // 3 = Storing Arb Sequence in EEPROM, falling back to Mode 0
                             // 4 = Recalling Arb Sequence from EEPROM, falling back to Mode 0
+                            // 5 = Streaming values (ArbActive = 3), by parameters 186+187, until a time value of 0 has been loaded
 
 uint8_t ArbSelectRAM = 0;   // for Parameter 189
                             // select RAM predefined sequence
 
+uint8_t ArbSwapMode = 0;    // for Parameter 190
+                            // 0 = new values are played at once, 1 = new values are played after the current sequence has finished
+
+uint8_t ArbFuncShape = ARBFUNC_SINE;    // for Parameter 194
+                            // 0 = sine, 1 = triangle, 2 = sawtooth, 3 = square, 4 = exponential charge/discharge
+
+float ArbFuncFreq = 1.0;    // for Parameter 195
+                            // frequency of the function generator in Hz
+
+float ArbFuncAmp = 0.5;     // for Parameter 196
+                            // amplitude (peak) of the function generator, 0.0..1.0 of dcv
+
+float ArbFuncOffset = 0.5;  // for Parameter 197
+                            // offset (mean level) of the function generator, 0.0..1.0 of dcv
+
+uint8_t ArbFuncDuty = 50;   // for Parameter 198
+                            // duty cycle in %: rising part of triangle and exponential, high part of square
+
+uint8_t ArbTarget = ARBTARGET_U;    // for Parameter 176
+                            // 0 = voltage, 1 = current, 2 = voltage and current in lockstep (ROM and RAM mode)
+
+uint8_t ArbSelectI = 0;     // for Parameter 177
+                            // sequence for the current if ArbTarget = 2, ROM or RAM like the voltage sequence
+
 uint8_t ArbRAMOffset = 0;   // Offset in RAM array, ArbRAMOffset = get_SequenceStart_RAMarray(&ArbSelectRAM); internally used only.
 
 float ArbMinVoltage = 0.0; // to calculate the voltage range for Arbitrary Mode with respect to relay switching; internally used only
@@ -260,41 +304,68 @@ float ArbMinVoltage = 0.0; // to calculate the voltage range for Arbitrary Mode
 
 
 //*** Arbitrary Mode variables ******************************************************
-#define  ARBINDEXMAX 50
-uint16_t ArbDAC[ARBINDEXMAX];   // DAC in raw values
-uint16_t ArbT[ARBINDEXMAX];     // Duration in ms
+//#define ARBINDEXMAX  ==> moved to dcg.h
+#ifdef ARBDOUBLEBANK
+ARBTABLE ArbTable[2];                       // two banks: one is played by the ISR, the other one is filled by SetLevelDAC
+#else
+ARBTABLE ArbTable[1];                       // one bank: the ISR holds its output while SetLevelDAC fills it
+#endif
+ARBTABLE* ArbTablePlay = &ArbTable[0];      // bank played by the ISR, 0 while the only bank is filled
+ARBTABLE* ArbTableNext = 0;                 // bank to be played next, set by SetLevelDAC, taken over by the ISR
+uint8_t  ArbSwapAtOnce = 0;     // 0 = ISR takes over ArbTableNext at the end of the sequence, 1 = at the next tick
 uint8_t  ArbTrigger = 0;        // ISR value for ArbRepeat
 int16_t  ArbDelayISR = 0;       // ISR value for ArbDelay
+uint8_t  ArbPrgRestart = 0;     // 1 = ISR starts the program with the first instruction
+uint8_t  ArbPrgTrigger = 0;     // for Parameter 117, set by the host, cleared by ARBOP_WAIT
+uint8_t  ArbPrgPC = 0;          // for Parameter 118, instruction executed by the ISR
 // for interrupt routine --> timer.c
 //***********************************************************************************
 
 
+//*** Streaming of arbitrary segments (ArbActive = 3) ***********************************
+ARBSTREAM ArbStream;                // ring buffer, filled by ArbStreamPut, played by the ISR
+uint16_t ArbStreamUnderrun = 0;     // for Parameter 192, number of underruns of the ring buffer
+
+ARBFUNC ArbFuncISR;                 // function generator values for the ISR, calculated by SetLevelDAC
+
+ARBINSTR     ArbPrg[ARBPRGMAX];     // program as loaded by Parameter 116
+ARBINSTRLINK ArbPrgLink[2][ARBPRGMAX];              // DAC values and reciprocal durations for the ISR, calculated by SetLevelDAC
+ARBINSTRLINK* ArbPrgLinkPlay = ArbPrgLink[0];       // bank used by the ISR, the other one is linked and swapped in
+uint16_t     ArbPrgStartDAC;        // level at the start of the program (100%)
+
+static uint8_t  ArbStreamRange = 0;     // voltage range of the stream, fixed at the start of the stream
+static uint8_t  ArbStreamPending = 0;   // 1 = ArbStreamLastDAC/T is waiting for the next point to calculate its slope
+static uint16_t ArbStreamLastDAC;
+static uint16_t ArbStreamLastT;
+//***********************************************************************************
+
+
 //*** Arbitrary sequences in ROM (!) ************************************************
 #define ARBSEQUENCECOUNT 4
 
 const PROGMEM  char ArbL_ISO4[9]      = "ISO4    ";
-const PROGMEM float ArbV_ISO4[]      = {  1.0,  1.0,0.416667, 0.416667,   0.666667,  0.666667 ,1.0}; // ISO-4
+const PROGMEM uint16_t ArbV_ISO4[]      = {  ARBV(1.0),  ARBV(1.0),ARBV(0.416667), ARBV(0.416667),   ARBV(0.666667),  ARBV(0.666667) ,ARBV(1.0)}; // ISO-4
 const PROGMEM uint16_t ArbTd_ISO4[]   = {  200,   20,   50,   10,   100,   20,    0};                 // Duration in ms
 
 const PROGMEM char ArbL_ISO4m[9]      = "ISO4m   ";
-const PROGMEM float ArbV_ISO4m[]     = {  1.0,  0.916667 ,0.416667, 0.5,   0.666667,  0.75 ,1.0};   // ISO-4 with modified shape
+const PROGMEM uint16_t ArbV_ISO4m[]     = {  ARBV(1.0),  ARBV(0.916667) ,ARBV(0.416667), ARBV(0.5),   ARBV(0.666667),  ARBV(0.75) ,ARBV(1.0)};   // ISO-4 with modified shape
 
 const PROGMEM char ArbL_Graetz[9]     = "Graetz  ";
 #if defined DUAL_DAC && ! defined DEBUGSTDHW
-const PROGMEM float ArbV_Graetz[]    = { 1.0000, 0.9511, 0.8090, 0.5878, 0.3090, 0.0000, 0.3090, 0.5878, 0.8090, 0.9511, 1.0000};   // Steps in Volts // Sinus
+const PROGMEM uint16_t ArbV_Graetz[]    = { ARBV(1.0000), ARBV(0.9511), ARBV(0.8090), ARBV(0.5878), ARBV(0.3090), ARBV(0.0000), ARBV(0.3090), ARBV(0.5878), ARBV(0.8090), ARBV(0.9511), ARBV(1.0000)};   // Steps in Volts // Sinus
 const PROGMEM uint16_t ArbTd_Graetz[] = { 1,       1,      1,      1,      1,      1,      1,      1,      1,      1,      0    };   // Duration in ms
 #else
-const PROGMEM float ArbV_Graetz[]    = { 1.0000, 0.5878, 0.0000,  0.5878, 1.0000, 1.0000};   // Steps in Volts // Sinus
+const PROGMEM uint16_t ArbV_Graetz[]    = { ARBV(1.0000), ARBV(0.5878), ARBV(0.0000),  ARBV(0.5878), ARBV(1.0000), ARBV(1.0000)};   // Steps in Volts // Sinus
 const PROGMEM uint16_t ArbTd_Graetz[] = { 2,       2,      2,      2,      2,       0    };   // Duration in ms
 #endif
 
 
 const PROGMEM char ArbL_3Peaks[9]     = "3Peaks  ";
 #if defined DUAL_DAC && ! defined DEBUGSTDHW
-const PROGMEM float ArbV_3Peaks[]    = { 1.0, 1.0,  0.416667,  1.0,  1.0,  0.666667 ,  1.0,  1.0,  0.833333 ,1.0}; // 3 Peaks down to 5V, 8V and 10V
+const PROGMEM uint16_t ArbV_3Peaks[]    = { ARBV(1.0), ARBV(1.0),  ARBV(0.416667),  ARBV(1.0),  ARBV(1.0),  ARBV(0.666667) ,  ARBV(1.0),  ARBV(1.0),  ARBV(0.833333) ,ARBV(1.0)}; // 3 Peaks down to 5V, 8V and 10V
 const PROGMEM uint16_t ArbTd_3Peaks[] = { 200,   1,   1,         10,    1,     1,       10,    1,     1,       0};  // Duration in ms
 #else
-const PROGMEM float ArbV_3Peaks[]    = { 1.0, 1.0,  0.416667,  1.0,  1.0,  0.666667 , 1.0,  1.0,  0.833333 , 1.0, 1.0};  // 3 Peaks down to 5V, 8V and 10V
+const PROGMEM uint16_t ArbV_3Peaks[]    = { ARBV(1.0), ARBV(1.0),  ARBV(0.416667),  ARBV(1.0),  ARBV(1.0),  ARBV(0.666667) , ARBV(1.0),  ARBV(1.0),  ARBV(0.833333) , ARBV(1.0), ARBV(1.0)};  // 3 Peaks down to 5V, 8V and 10V
 const PROGMEM uint16_t ArbTd_3Peaks[] = { 198,   2,   2,        8,    2,     2,       8,    2,     2,       2  , 0};    // Duration in ms
 #endif
 
@@ -306,7 +377,7 @@ const char PROGMEM* const PROGMEM ArbArrayL[ARBSEQUENCECOUNT] =
     ArbL_3Peaks
 };
 
-const float PROGMEM* const PROGMEM ArbArrayV[ARBSEQUENCECOUNT] =
+const uint16_t PROGMEM* const PROGMEM ArbArrayV[ARBSEQUENCECOUNT] =
 {
     ArbV_ISO4,
     ArbV_ISO4m,
@@ -325,24 +396,28 @@ const uint16_t PROGMEM* const PROGMEM ArbArrayT[ARBSEQUENCECOUNT] =
 
 
 //*** Arbitrary sequences in EEPROM (!) *********************************************
-float   ArbV_EEP[ARBINDEXMAXRAM]  EEMEM;
+uint16_t ArbV_EEP[ARBINDEXMAXRAM]  EEMEM;
 uint16_t ArbT_EEP[ARBINDEXMAXRAM]  EEMEM;
+uint8_t  ArbLayout_EEP             EEMEM;      // ARBEEPLAYOUT, written after the array
 //***********************************************************************************
 
 
 //*** Arbitrary sequences in RAM (!) ************************************************
 //#define ARBINDEXMAXRAM  ==> moved to dcg.h
-float   ArbV_RAM[ARBINDEXMAXRAM];
+uint16_t ArbV_RAM[ARBINDEXMAXRAM];   // relative voltage 0.0..1.0 as 0..65535, see ARBV()
 uint16_t ArbT_RAM[ARBINDEXMAXRAM];
 
+ARBDIR  ArbDir[ARBDIRMAX];          // directory of the sequences in ArbV_RAM/ArbT_RAM, see ArbDirBuild()
+uint8_t ArbDirCount = 0;            // number of valid entries in ArbDir
+
 #ifdef PRELOAD_ARB_RAM
 
 //*** predefined arbitrary sequences for RAM / for testing only ***
 #if defined DUAL_DAC && ! defined DEBUGSTDHW
-const PROGMEM float   ArbV_RAM_ROM[] = { 1.0, 1.0, 0.2, 0.4,  0.6,  0.5 , 1.0, 1.0000, 0.9511, 0.8090, 0.5878, 0.3090, 0.0000, 0.3090, 0.5878, 0.8090, 0.9511, 1.0000, 1.0,  0.916667 ,0.416667, 0.5,   0.666667,  0.75 ,1.0};   // Variant of ISO-4 + Graetz + ISO4
+const PROGMEM uint16_t   ArbV_RAM_ROM[] = { ARBV(1.0), ARBV(1.0), ARBV(0.2), ARBV(0.4),  ARBV(0.6),  ARBV(0.5) , ARBV(1.0), ARBV(1.0000), ARBV(0.9511), ARBV(0.8090), ARBV(0.5878), ARBV(0.3090), ARBV(0.0000), ARBV(0.3090), ARBV(0.5878), ARBV(0.8090), ARBV(0.9511), ARBV(1.0000), ARBV(1.0),  ARBV(0.916667) ,ARBV(0.416667), ARBV(0.5),   ARBV(0.666667),  ARBV(0.75) ,ARBV(1.0)};   // Variant of ISO-4 + Graetz + ISO4
 const PROGMEM uint16_t ArbT_RAM_ROM[] = { 200,  20,  50,  10,  100,   20,    0, 1,       1,      1,      1,      1,      1,      1,      1,      1,      1,      0,     200,    20,       50,     10,       100,     20,    0};   // Duration in ms
 #else
-const PROGMEM float   ArbV_RAM_ROM[] = { 1.0, 1.0, 0.2, 0.4,  0.6,  0.5 , 1.0, 1.0000, 0.5878, 0.0000,  0.5878, 1.0000, 1.0000, 1.0,  0.916667 ,0.416667, 0.5,   0.666667,  0.75 ,1.0};   // Variant of ISO-4 + Graetz + ISO4
+const PROGMEM uint16_t   ArbV_RAM_ROM[] = { ARBV(1.0), ARBV(1.0), ARBV(0.2), ARBV(0.4),  ARBV(0.6),  ARBV(0.5) , ARBV(1.0), ARBV(1.0000), ARBV(0.5878), ARBV(0.0000),  ARBV(0.5878), ARBV(1.0000), ARBV(1.0000), ARBV(1.0),  ARBV(0.916667) ,ARBV(0.416667), ARBV(0.5),   ARBV(0.666667),  ARBV(0.75) ,ARBV(1.0)};   // Variant of ISO-4 + Graetz + ISO4
 const PROGMEM uint16_t ArbT_RAM_ROM[] = { 200,  20,  50,  10,  100,   20,    0, 2,       2,      2,      2,      2,       0,     200,    20,       50,     10,       100,     20,    0};   // Duration in ms
 
 #endif
@@ -356,7 +431,7 @@ void init_Arb_RAMarray(void)
 
     for (i = 0; i < ARBINDEXMAXRAM; i++)
     {
-        ArbV_RAM[i] = 1.0;
+        ArbV_RAM[i] = ARBV(1.0);
         ArbT_RAM[i] = 0;  // initialize time steps with "0"s, they are used to separate multiple sequences
     }
 
@@ -365,37 +440,285 @@ void init_Arb_RAMarray(void)
     memcpy_P(&ArbT_RAM, &ArbT_RAM_ROM, sizeof(ArbT_RAM_ROM));
 #endif
 
+    ArbDirBuild();
+}
+
+//*** slope between two DAC values for the interpolation in the ISR ***
+// Result is DAC steps per time unit of Time (ms for the stream, the unit of the step for the table)
+// in 16.16 fixed point. The division is done here once per point, so the ISR only has to add the slope every tick.
+uint32_t CalcArbSlope(uint16_t From, uint16_t To, uint32_t Time)
+{
+    uint16_t Diff;
+    uint32_t Slope;
+
+    if (Time == 0)
+    {
+        return 0;
+    }
+
+    Diff = (To >= From) ? To - From : From - To;
+    Slope = ((uint32_t)(Diff / Time) << 16) + (((uint32_t)(Diff % Time) << 16) / Time);
+
+    return (To >= From) ? Slope : -Slope;
+}
+
+//*** time units of the arbitrary arrays, see ARBT() ***
+const uint16_t ArbUnitMs[4] = {1, 100, 1000, 60000};
+
+// T units of Unit into the array format, changes to a coarser unit (rounded) if the count doesn't fit.
+// The caller compares with ArbTimeMs to find out about the rounding.
+uint16_t ArbTimeEncode(uint16_t T, uint8_t Unit)
+{
+    static const uint8_t NextFactor[3] = {100, 10, 60};
+
+    if (T == 0)
+    {
+        return 0;
+    }
+    while ((T > ARBT_COUNTMASK) && (Unit < ARBT_UNIT_MIN))
+    {
+        T = (T + NextFactor[Unit] / 2) / NextFactor[Unit];
+        Unit++;
+    }
+    if (T > ARBT_COUNTMASK)
+    {
+        T = ARBT_COUNTMASK;
+    }
+    return ARBT(T, Unit);
+}
+
+// duration of the coded time value in ms
+uint32_t ArbTimeMs(uint16_t T)
+{
+    return (uint32_t)(T & ARBT_COUNTMASK) * ArbUnitMs[T >> 14];
+}
+
+//*** conversion of a relative voltage 0.0..1.0 of wVoltage into a DAC value of the given range ***
+static uint16_t ArbCalcDAC(float V, uint8_t Range)
+{
+    int32_t tmpDAC;
+
+    tmpDAC = (int32_t)(V * wVoltage * DCVoltMod / DACLSBU[Range] + 0.5) + Params.DACUOffsets[Range];
+    if (tmpDAC > DACMax)
+    {
+        tmpDAC = DACMax;
+    }
+    else if (tmpDAC < 0)
+    {
+        tmpDAC = 0;
+    }
+    return tmpDAC;
+}
+
+//*** conversion of a relative value (see ARBV) into a DAC value, without float math ***
+// Scale is the DAC steps for 100% in 8.16 fixed point (see SetLevelDAC), each point is clipped
+// to 0..DACMax on its own, so points within the range keep their shape.
+static uint16_t ArbScaleDAC(uint16_t V, uint32_t Scale, int16_t Offset)
+{
+    int32_t tmpDAC;
+
+    tmpDAC = (int32_t)((uint32_t)V * (Scale >> 16) + (((uint32_t)V * (uint16_t)Scale + 0x8000) >> 16)) + Offset;
+    if (tmpDAC > DACMax)
+    {
+        tmpDAC = DACMax;
+    }
+    else if (tmpDAC < 0)
+    {
+        tmpDAC = 0;
+    }
+    return tmpDAC;
+}
+
+//*** Streaming: start a new stream with an empty ring buffer ***
+// The voltage range can't be derived from values which are not known yet, so it is taken
+// from wVoltage (or LockRangeU) and kept until the next start of a stream.
+void ArbStreamReset(void)
+{
+    uint8_t sreg;
+    uint16_t Hold;
+
+    if (LockRangeU == 255)
+    {
+        ArbStreamRange = (wVoltage > Params.MaxVoltage[0]) ? 1 : 0;
+    }
+    else
+    {
+        ArbStreamRange = LockRangeU;
+    }
+    Hold = ArbCalcDAC(1.0, ArbStreamRange);       // until the first segment arrives, the output is set to 100%
+    ArbStreamPending = 0;
+
+    sreg = SREG;
+    cli();
+    ArbStream.Head = ArbStream.Tail = 0;
+    ArbStream.Playing = 0;
+    ArbStream.Hold = Hold;
+    ArbStreamUnderrun = 0;
+    SREG = sreg;
+}
+
+//*** Streaming: number of segments waiting in the ring buffer, for Parameter 191 ***
+uint8_t GetArbStreamLevel(void)
+{
+    return (ArbStream.Head - ArbStream.Tail) & (ARBSTREAMSIZE - 1);
+}
+
+//*** Streaming: append a point (relative voltage, duration in ms) to the stream ***
+// A segment is written to the ring buffer when the following point is known, because the
+// slope needs both ends. A duration of 0 marks the end of the stream, the ISR holds this point.
+// Returns 0 if the ring buffer is full, the point has to be sent again later.
+uint8_t ArbStreamPut(float V, uint16_t T)
+{
+    uint8_t Head = ArbStream.Head;
+    uint8_t Need = ArbStreamPending + (T == 0);
+    uint8_t sreg;
+    uint16_t DAC;
+
+    if ((ARBSTREAMSIZE - 1) - GetArbStreamLevel() < Need)
+    {
+        return 0;
+    }
+
+    DAC = ArbCalcDAC(V, ArbStreamRange);
+
+    if (ArbStreamPending)
+    {
+        ArbStream.DAC[Head] = ArbStreamLastDAC;
+        ArbStream.T[Head]   = ArbStreamLastT;
+        ArbStream.Inc[Head] = CalcArbSlope(ArbStreamLastDAC, DAC, ArbStreamLastT);
+        Head = (Head + 1) & (ARBSTREAMSIZE - 1);
+    }
+
+    if (T == 0)                     // end of stream
+    {
+        ArbStream.DAC[Head] = DAC;
+        ArbStream.T[Head]   = 0;
+        ArbStream.Inc[Head] = 0;
+        Head = (Head + 1) & (ARBSTREAMSIZE - 1);
+        ArbStreamPending = 0;
+    }
+    else
+    {
+        ArbStreamLastDAC = DAC;
+        ArbStreamLastT = T;
+        ArbStreamPending = 1;
+    }
+
+    // publish the new segments, cli() makes sure that they are written before Head
+    sreg = SREG;
+    cli();
+    ArbStream.Head = Head;
+    SREG = sreg;
+
+    return 1;
 }
 
 //*** automagic search for sequences in the RAM array ***
 uint8_t get_SequenceStart_RAMarray(uint8_t* select)
 {
-    uint8_t i = 0;
-    uint8_t first = 0;
-    uint8_t found = 0;
+    ARBDIR Dir;
 
-    while (i < ARBINDEXMAXRAM)
+    if (*select >= ArbDirCount)
     {
-        if (ArbT_RAM[i] == 0)           // time value == 0 is the end marker of a sequence
+        *select = ArbDirCount - 1;  // update the variable to the maximum available
+    }
+    ArbDirGet(*select, &Dir);
+    return Dir.Start;               // return the appropriate index in the array
+}
+
+//*** scan the sequence starting at Start into *pDir ***
+// Returns the start of the next sequence, ARBINDEXMAXRAM at the end of the array.
+static uint8_t ArbDirScan(uint8_t Start, ARBDIR* pDir)
+{
+    uint8_t i;
+
+    pDir->Start = Start;
+    pDir->Min = pDir->Max = ArbV_RAM[Start];
+
+    for (i = Start; i < ARBINDEXMAXRAM; i++)
+    {
+        if (ArbV_RAM[i] < pDir->Min)
+        {
+            pDir->Min = ArbV_RAM[i];
+        }
+        if (ArbV_RAM[i] > pDir->Max)
+        {
+            pDir->Max = ArbV_RAM[i];
+        }
+
+        if (ArbT_RAM[i] == 0)       // time value == 0 is the end marker of a sequence
         {
-            i++;
-            if ( i < ARBINDEXMAXRAM)
+            pDir->Length = i + 1 - Start;
+
+            while ((i + 1 < ARBINDEXMAXRAM) && (ArbT_RAM[i + 1] == 0))
             {
-                if (ArbT_RAM[i] != 0)   // check, if the next value is non-zero, it might be the beginning of a new sequence
-                {
-                    found++;            // record the number of found sequences.
-                    first = i;          // record the index in the array.
-                }
+                i++;                // skip unused points
             }
+            return i + 1;           // the next non-zero time value is the beginning of a new sequence
         }
-        // found the wanted sequence
-        if (found == *select)           // don't change the selection
-            return first;               // return the appropriate index in the array.
-        i++;
-    }
-                        // in case the end of the RAM array has been found without finding the wanted sequence,
-    *select = found;    // update the variable to the maximum available
-    return first;       // return the appropriate index in the array
+    }
+    pDir->Length = ARBINDEXMAXRAM - Start;     // last sequence without end marker
+    return ARBINDEXMAXRAM;
+}
+
+//*** build the directory of the sequences in the RAM array ***
+// A sequence starts at index 0 or after an end marker (time value 0) followed by a non-zero time value.
+// Has to be called whenever the RAM array has been changed as a whole (finalisation of loading, recall, init).
+// ArbDirCount counts all sequences, the ones behind the first ARBDIRMAX are scanned by ArbDirGet when selected.
+void ArbDirBuild(void)
+{
+    ARBDIR Dir;
+    uint8_t Next = 0;
+
+    ArbDirCount = 0;
+    do
+    {
+        Next = ArbDirScan(Next, (ArbDirCount < ARBDIRMAX) ? &ArbDir[ArbDirCount] : &Dir);
+        ArbDirCount++;
+    }
+    while (Next < ARBINDEXMAXRAM);
+}
+
+//*** directory entry of the sequence Seq (< ArbDirCount) ***
+void ArbDirGet(uint8_t Seq, ARBDIR* pDir)
+{
+    uint8_t Next;
+    uint8_t i;
+
+    if (Seq < ARBDIRMAX)
+    {
+        *pDir = ArbDir[Seq];
+        return;
+    }
+
+    Next = ArbDir[ARBDIRMAX - 1].Start;         // behind the directory: scan on from its last entry
+    for (i = ARBDIRMAX - 1; i <= Seq; i++)
+    {
+        Next = ArbDirScan(Next, pDir);
+    }
+}
+
+//*** Save/recall the RAM array to/from EEPROM, the directory is built from the recalled array ***
+void ArbSave_EEP(void)
+{
+    eeprom_write_block(ArbV_RAM, ArbV_EEP, sizeof(ArbV_RAM));
+    eeprom_write_block(ArbT_RAM, ArbT_EEP, sizeof(ArbT_RAM));
+    eeprom_write_byte(&ArbLayout_EEP, ARBEEPLAYOUT);
+}
+
+// Returns 0 and keeps the RAM array if the EEPROM holds another layout (older firmware or not saved yet)
+uint8_t ArbRecall_EEP(void)
+{
+    if (eeprom_read_byte(&ArbLayout_EEP) != ARBEEPLAYOUT)
+    {
+        return 0;
+    }
+    eeprom_read_block(ArbV_RAM, ArbV_EEP, sizeof(ArbV_RAM));
+    eeprom_read_block(ArbT_RAM, ArbT_EEP, sizeof(ArbT_RAM));
+
+    ArbDirBuild();
+    ArbRAMOffset = get_SequenceStart_RAMarray(&ArbSelectRAM);
+    return 1;
 }
 //***********************************************************************************
 
@@ -554,8 +877,46 @@ void CheckLimits(void)
     }
 #endif
 
+    LIMIT_UINT8(&ADCSamples, 2 , 8);
+    ADCSamples = (ADCSamples >= 8) ? 8 : (ADCSamples >= 4) ? 4 : 2;    // powers of 2 only, averaged by a shift
+    LIMIT_UINT8(&SHRefresh, 1 , 50);                    // hold time of a S&H up to 99ms
+#ifdef WAVETICK
+    LIMIT_UINT8(&WaveTicks, 1 , 8);
+    WaveTicks = (WaveTicks >= 8) ? 8 : (WaveTicks >= 4) ? 4 : (WaveTicks >= 2) ? 2 : 1;  // powers of 2, the ISR interpolates by a shift
+#else
+    WaveTicks = 1;
+#endif
+    LIMIT_UINT8(&ProfSelect, 0 , PROF_COUNT-1);
+#ifdef CAPTURE
+    LIMIT_INT16(&CapturePre, 0, CAPTURESIZE - 1);
+    LIMIT_INT16(&CapturePost, 1, CAPTURESIZE - CapturePre);    // the record fits into the buffer
+#endif
+    LIMIT_UINT8(&CaptureDecimation, 1 , 255);
+    LIMIT_UINT8(&CaptureSource, 0 , CAPTURE_SRC_MAX);
+    LIMIT_FLOAT(&CaptureLevel, 0.0, 100.0);             // V or A of the threshold sources
+    LIMIT_FLOAT(&CaptureLevelHigh, CaptureLevel, 100.0);
+    LIMIT_INT16(&StatWindow, 0, STAT_WINDOWMAX);
+    LIMIT_UINT8(&StatSelect, 0 , STAT_CHANNELS-1);
+    LIMIT_INT16(&TeleInterval, 0, TELEINTERVALMAX);
+    if ((TeleInterval != 0) && (TeleInterval < TELEINTERVALMIN))
+    {
+        TeleInterval = TELEINTERVALMIN;
+    }
+    LIMIT_INT16(&TeleOffset, 0, TELEINTERVALMAX);
+    LIMIT_FLOAT(&TeleDeadbandU, 0.0, 100.0);
+    LIMIT_FLOAT(&TeleDeadbandI, 0.0, 100.0);
+
     LIMIT_UINT8(&ArbSelect, 0 , ARBSEQUENCECOUNT-1);    // select ROM predefined sequence
-    LIMIT_UINT8(&ArbActive, 0 , 2);                     // 0 = off , 1= ROM, 2= RAM
+    LIMIT_UINT8(&ArbActive, 0 , 5);                     // 0 = off , 1= ROM, 2= RAM, 3= Stream, 4= Function, 5= Program
+    LIMIT_UINT8(&ArbFuncShape, 0 , ARBFUNC_EXP);
+    LIMIT_FLOAT(&ArbFuncFreq, 0.0, 100.0);              // in Hz, at least 10 (5) ticks per period at 1 (2) ms
+    LIMIT_FLOAT(&ArbFuncAmp, 0.0, 1.0);
+    LIMIT_FLOAT(&ArbFuncOffset, 0.0, 1.0);
+    LIMIT_UINT8(&ArbFuncDuty, 1 , 99);
+    LIMIT_UINT8(&ArbSwapMode, 0 , 1);                   // 0 = at once, 1 = at the end of the sequence
+    LIMIT_UINT8(&ArbTarget, 0 , ARBTARGETMAX);          // 0 = voltage, 1 = current, 2 = both
+    LIMIT_UINT8(&ArbSelectI, 0 , ARBINDEXMAXRAM-1);     // checked against the number of sequences by SetLevelDAC
+    LIMIT_UINT8(&ArbRAMtmpTUnit, 0 , ARBT_UNIT_MIN);    // 0 = ms, 1 = 100 ms, 2 = s, 3 = min
 //  LIMIT_UINT8(&ArbRepeat, 0 , 255);                   // 0 = off , 1-254 count, 255= continuous  -> full range, test not necessary.
     LIMIT_INT16(&ArbDelay,  0, 30000);                  // 0 = off, 1..65000 in ms
 
@@ -578,7 +939,7 @@ void CheckLimits(void)
 
 void CalcAmpWattHours(void)
 {
-    float dAmps = xCurrent;
+    float dAmps = GetCurrent();
 
     if ( RippleActive )
     {
@@ -590,11 +951,30 @@ void CalcAmpWattHours(void)
     {
         // called every 100ms = 1/(3600 * 10) h
         // don't add anything for too low current values
-        xAmpHours   += xCurrent / 36000;
-        xWattHours  += xCurrent * xVoltage / 36000;
+        xAmpHours   += dAmps / 36000;
+        xWattHours  += dAmps * GetVoltage() / 36000;
     }
 }
 
+// raw ADC value + offset in uV or 10nA: Mul = ADCMulU/ADCMulI, 16x16 bit multiplications only
+static int32_t ADCScale(int32_t Raw, uint32_t Mul)
+{
+    uint32_t a = (Raw < 0) ? -Raw : Raw;
+    uint32_t r;
+
+    a <<= ADCRawShift;
+    if (a > 0xffff)
+    {
+        a = 0xffff;
+    }
+    r = (uint32_t)(uint16_t)a * (uint16_t)(Mul >> 16) + (((uint32_t)(uint16_t)a * (uint16_t)Mul) >> 16);
+    if (r > INT32_MAX)
+    {
+        r = INT32_MAX;
+    }
+    return (Raw < 0) ? -(int32_t)r : (int32_t)r;
+}
+
 void jobGetValues(void)
 {
     static uint8_t lastRangeI = 0xff;
@@ -612,12 +992,14 @@ void jobGetValues(void)
     {
         lastRangeI = RangeI;
         waitITimer = 10;    // 40ms
+        StatRestart(STAT_SETTLE);
     }
 
     if (lastRangeU != RangeU)
     {
         lastRangeU = RangeU;
         waitUTimer = 10;    // 40ms
+        StatRestart(STAT_SETTLE);
     }
 
     if (waitUTimer)
@@ -640,10 +1022,10 @@ void jobGetValues(void)
             Values.u16[0] = ValuesLow.u16[0] = GetADC(2); // Ripple measurement not implemented in 12-bit mode
         }
 
-        xVoltage = (Values.i32 + Params.ADCUOffsets[lastRangeU]) * ADCLSBU[lastRangeU];
-        xVoltageLow = (ValuesLow.i32 + Params.ADCUOffsets[lastRangeU]) * ADCLSBU[lastRangeU];
+        xVoltage_uV = ADCScale(Values.i32 + Params.ADCUOffsets[lastRangeU], ADCMulU[lastRangeU]);
+        xVoltageLow_uV = ADCScale(ValuesLow.i32 + Params.ADCUOffsets[lastRangeU], ADCMulU[lastRangeU]);
 
-        xMeanVoltage = (3 * xMeanVoltage + xVoltage) / 4;   // Note: Pascal FW uses 7/8
+        xMeanVoltage_uV += (xVoltage_uV - xMeanVoltage_uV) / 4;     // Note: Pascal FW uses 7/8
     }
 
     if (waitITimer)
@@ -666,23 +1048,60 @@ void jobGetValues(void)
         {
             Values.u16[0] = ValuesLow.u16[0] = GetADC(3);
         }
-        xCurrent = (Values.i32 + Params.ADCIOffsets[lastRangeI]) * ADCLSBI[lastRangeI];
-        xCurrentLow = (ValuesLow.i32 + Params.ADCIOffsets[lastRangeI]) * ADCLSBI[lastRangeI];
+        xCurrent_10nA = ADCScale(Values.i32 + Params.ADCIOffsets[lastRangeI], ADCMulI[lastRangeI]);
+        xCurrentLow_10nA = ADCScale(ValuesLow.i32 + Params.ADCIOffsets[lastRangeI], ADCMulI[lastRangeI]);
 
-        xMeanCurrent = (3 * xMeanCurrent + xCurrent) / 4;   // Note: Pascal FW uses 7/8
+        xMeanCurrent_10nA += (xCurrent_10nA - xMeanCurrent_10nA) / 4;     // Note: Pascal FW uses 7/8
     }
+}
+
+// measured values in V, A and W for the bus and the panel
+float GetVoltage(void)
+{
+    return xVoltage_uV * 1e-6f;
+}
+
+float GetVoltageLow(void)
+{
+    return xVoltageLow_uV * 1e-6f;
+}
 
-    xPower = xVoltage * xCurrent;
+float GetCurrent(void)
+{
+    return xCurrent_10nA * 1e-8f;
+}
+
+float GetCurrentLow(void)
+{
+    return xCurrentLow_10nA * 1e-8f;
+}
+
+float GetMeanVoltage(void)
+{
+    return xMeanVoltage_uV * 1e-6f;
+}
+
+float GetMeanCurrent(void)
+{
+    return xMeanCurrent_10nA * 1e-8f;
+}
+
+float GetPower(void)
+{
+    return GetVoltage() * GetCurrent();
+}
+
+float GetPowerTot(void)
+{
+    float PowerTot = GetPower();
 
     if ( RippleActive )
     {
-        xPowerTot = (xPower * Params.RippleOn + xVoltageLow * xCurrentLow * Params.RippleOff) / (Params.RippleOn + Params.RippleOff + 0.0001f);
+        PowerTot = (PowerTot * Params.RippleOn + GetVoltageLow() * GetCurrentLow() * Params.RippleOff) / (Params.RippleOn + Params.RippleOff + 0.0001f);
     }
-    else
-        xPowerTot = xPower;
-
-    LIMIT_FLOAT(&xPowerTot, 0.0000001, 100000.0); // actually only to ensure non-negative values
 
+    LIMIT_FLOAT(&PowerTot, 0.0000001, 100000.0); // actually only to ensure non-negative values
+    return PowerTot;
 }
 
 
@@ -691,6 +1110,14 @@ float GetPowerIn(void)
     return GetADC(4) * PwrInFac;
 }
 
+// multiplier of ADCScale: Unit per LSB of a 16 bit value in 16.16 fixed point, Lsb = Unit per LSB of the ADC
+static uint32_t ADCMul(float Lsb, uint32_t ADCMax)
+{
+    float Mul = Lsb * ADCMax;       // * 65536 / (65536 / ADCMax)
+
+    return (Mul >= 4294967295.0) ? 0xffffffffUL : (uint32_t)(Mul + 0.5);
+}
+
 void InitScales(void)
 {
     float Ufac;
@@ -720,6 +1147,7 @@ void InitScales(void)
     for (i = 0; i < 2; i++)
     {
         ADCLSBU[i] = Params.ADCUfacs[i] * Params.ADCUScales[i] * Params.RefVoltage * Params.GainOut / tmpADCMax;
+        ADCMulU[i] = ADCMul(ADCLSBU[i] * 1e6, tmpADCMax);
     }
 
     Ufac *= Params.GainI;   // Spannungsteiler nach DAC-I auf 1/4 (0.25), R34, R33
@@ -734,7 +1162,9 @@ void InitScales(void)
     {
 	    // mA pro LSBit fr 4 Bereiche, Input:
 	    ADCLSBI[i] = Params.ADCIScales[i] * Params.RefVoltage / (2 * Params.RSense[i]) / tmpADCMax; // X2 durch U11
+        ADCMulI[i] = ADCMul(ADCLSBI[i] * 1e8, tmpADCMax);
     }
+    ADCRawShift = Params.Options.ADC16Present ? 0 : 6;
 
     PwrInFac = Params.RefVoltage * Params.GainPwrIn / 1024;
     DACMax = tmpDACMax - 1; // fr SetLevelDAC
@@ -751,6 +1181,8 @@ void InitScales(void)
     {
         InitLockRangeI = 255;
     }
+
+    Timer_SelectHandlers();     // DAC and ADC driver of the options
 }
 
 uint8_t CalcRangeI(float I)
@@ -765,18 +1197,110 @@ uint8_t CalcRangeI(float I)
     return Range;
 }
 
+//*** Program: convert the loaded instructions into DAC values for the ISR ***
+// Links into the bank the ISR doesn't use and swaps it in at once, so a running program never sees
+// a mix of old and new values. Returns the voltage range needed by the program, ArbMinVoltage is updated.
+static uint8_t ArbPrgLinkProgram(void)
+{
+    uint8_t i, Range;
+    uint16_t Min = 0xffff;
+    uint16_t Max = 0;
+    int32_t tmpDAC;
+    uint8_t sreg;
+    ARBINSTRLINK* pLink = (ArbPrgLinkPlay == ArbPrgLink[0]) ? ArbPrgLink[1] : ArbPrgLink[0];
+
+    for (i = 0; i < ARBPRGMAX; i++)
+    {
+        if (ArbPrg[i].Op == ARBOP_SEG)
+        {
+            if (ArbPrg[i].V < Min)
+                Min = ArbPrg[i].V;
+            if (ArbPrg[i].V > Max)
+                Max = ArbPrg[i].V;
+        }
+    }
+    if (Max < Min)                  // no segment at all
+    {
+        Min = Max = ARBV(1.0);
+    }
+
+    if (LockRangeU == 255)
+    {
+        Range = (Max * wVoltage / 65535.0 > Params.MaxVoltage[0]) ? 1 : 0;
+    }
+    else
+    {
+        Range = LockRangeU;
+    }
+    if (Range != RangeU)
+    {
+        DCVoltMod = 1; // Prozent-Faktor rcksetzen
+    }
+    ArbMinVoltage = Min * wVoltage / 65535.0;
+    ArbPrgStartDAC = ArbCalcDAC(1.0, Range);
+
+    for (i = 0; i < ARBPRGMAX; i++)
+    {
+        if (ArbPrg[i].Op == ARBOP_SETI)
+        {
+            tmpDAC = (int32_t)(ArbPrg[i].V / 65535.0 * wCurrent * DCAmpMod / DACLSBI[RangeI] + 0.5) + Params.DACIOffsets[RangeI];
+            if (tmpDAC > DACMax)
+            {
+                tmpDAC = DACMax;
+            }
+            else if (tmpDAC < 0)
+            {
+                tmpDAC = 0;
+            }
+            pLink[i].DAC = tmpDAC;
+        }
+        else
+        {
+            pLink[i].DAC = ArbCalcDAC(ArbPrg[i].V / 65535.0, Range);
+        }
+        pLink[i].Recip = (ArbPrg[i].T != 0) ? 0xffffffffUL / ArbPrg[i].T : 0;
+    }
+
+    sreg = SREG;
+    cli();
+    ArbPrgLinkPlay = pLink;
+    SREG = sreg;
+
+    return Range;
+}
+
 void SetLevelDAC(void)
 {
+    static uint8_t lastArbActive = 0;
     int32_t tmpDAC, rippleDAC;
     uint8_t Range;
     uint8_t sreg;
     uint8_t Index = 0;
 
-    float tmpArbV;
+    uint16_t tmpArbV;
     uint16_t tmpArbT;
-    const float* ArbArrayV_Ptr;
+    uint16_t ArbMinV = 0;
+    uint32_t ArbScale;
+    uint16_t lastArbDAC = 0;
+    uint32_t lastArbT = 0;          // duration of the last point in its unit
+    ARBTABLE* pArb;
+    const uint16_t* ArbArrayV_Ptr;
     const uint16_t* ArbArrayT_Ptr;
-    float RelativeMaxVoltage0;
+    uint32_t RelativeMaxVoltage0;
+    ARBDIR Dir;                     // directory entry of the RAM sequence
+#ifdef ARBTABLE_I
+    ARBDIR DirI;                    // directory entry of the RAM sequence for the current
+    uint16_t tmpArbI;
+    uint16_t tmpArbTI;
+    int32_t  tmpDACI;
+    uint32_t ArbScaleI;
+    uint16_t lastArbDACI = 0;
+    uint8_t  IndexI = 0;
+    uint8_t  SeqI;
+    const uint16_t* ArbArrayVI_Ptr = 0;
+    const uint16_t* ArbArrayTI_Ptr = 0;
+#endif
+    PROF_START(uint32_t, Timer_Cycles());
 
 //*** Conversion for Current *************************************************
 
@@ -876,44 +1400,119 @@ void SetLevelDAC(void)
         RangeU = Range;
         SREG = sreg;
     }
+    else if ( ArbActive == 3 )
+    {
+//*** Streaming Arbitrary Mode, the ISR plays the ring buffer filled by ArbStreamPut ****
+
+        if (ArbStreamRange != RangeU)
+        {
+            DCVoltMod = 1; // Prozent-Faktor rcksetzen
+        }
+        ArbMinVoltage = 0.0;    // future values are unknown, keep the input voltage high enough for the full range
+
+        sreg = SREG;
+        cli();
+        RangeU = ArbStreamRange;
+        SREG = sreg;
+    }
+    else if ( ArbActive == 4 )
+    {
+//*** Function generator, the ISR calculates the waveform from the values prepared here ***
+        ARBFUNC Func;
+        float Low, High;
+
+        Low = ArbFuncOffset - ArbFuncAmp;
+        High = ArbFuncOffset + ArbFuncAmp;
+        LIMIT_FLOAT(&Low, 0.0, 1.0);
+        LIMIT_FLOAT(&High, 0.0, 1.0);
+
+        if (LockRangeU == 255)
+        {
+            Range = (High * wVoltage > Params.MaxVoltage[0]) ? 1 : 0;
+        }
+        else
+        {
+            Range = LockRangeU;
+        }
+        if (Range != RangeU)
+        {
+            DCVoltMod = 1; // Prozent-Faktor rcksetzen
+        }
+        ArbMinVoltage = Low * wVoltage;
+
+        Func.Shape = ArbFuncShape;
+        Func.PhaseInc = (uint32_t)(ArbFuncFreq * 4294967.296 + 0.5);   // 2^32 / 1000 per ms
+        Func.Duty = (uint16_t)(ArbFuncDuty * 65536UL / 100);
+        Func.RiseScale = 0xffff0000UL / Func.Duty;
+        Func.FallScale = 0xffff0000UL / (0x10000UL - Func.Duty);
+        Func.DACLow = ArbCalcDAC(Low, Range);
+        Func.DACSpan = ArbCalcDAC(High, Range) - Func.DACLow;
+
+        sreg = SREG;
+        cli();
+        ArbFuncISR = Func;
+        RangeU = Range;
+        SREG = sreg;
+    }
+    else if ( ArbActive == 5 )
+    {
+//*** Program, the ISR interprets the instructions linked here ***************************
+        Range = ArbPrgLinkProgram();
+
+        sreg = SREG;
+        cli();
+        if (lastArbActive != 5)     // start the program when the mode is switched on
+        {
+            ArbPrgRestart = 1;
+        }
+        RangeU = Range;
+        SREG = sreg;
+    }
     else
     {
 //*** Begin of Code for Arbitrary Mode *************************************************
 
         // Option Multiple Sequence ROM_Array
         // Retrieve pointer to code for selected arbitray sequence
-        memcpy_P(&ArbArrayV_Ptr, &ArbArrayV[ArbSelect], sizeof(const float *));
+        memcpy_P(&ArbArrayV_Ptr, &ArbArrayV[ArbSelect], sizeof(const uint16_t *));
         memcpy_P(&ArbArrayT_Ptr, &ArbArrayT[ArbSelect], sizeof(const uint16_t *));
 
-        RelativeMaxVoltage0 = Params.MaxVoltage[0] / wVoltage;
+        // highest relative voltage of range 0, in the same format as the arrays
+        if (wVoltage > Params.MaxVoltage[0])
+        {
+            RelativeMaxVoltage0 = ARBV(Params.MaxVoltage[0] / wVoltage);
+        }
+        else
+        {
+            RelativeMaxVoltage0 = 0x10000;
+        }
 
-        if (LockRangeU == 255)
+        if ( ArbTarget == ARBTARGET_I ) // the voltage is static, the sequence is played on the current
+        {
+            ArbMinVoltage = wVoltage;
+            Range = (LockRangeU == 255) ? (wVoltage > Params.MaxVoltage[0]) : LockRangeU;
+        }
+        else if ( ArbActive == 2 ) // RAM mode, min/max are known from the directory
+        {
+            ArbDirGet(ArbSelectRAM, &Dir);
+            ArbMinVoltage = Dir.Min * wVoltage / 65535.0;
+            Range = (LockRangeU == 255) ? (Dir.Max > RelativeMaxVoltage0) : LockRangeU;
+        }
+        else if (LockRangeU == 255)
         {
             Range = 0;              // this section was for absolute values, can be significantly reduced for relative values 0.0-1.0
 
             Index = 0;
-            do      // for all voltage values of the array:
+            do      // for all voltage values of the ROM array:
             {
                 //      - find the highest voltage for correct Range setting
                 //      - find the lowest voltage for correct calculation of relay switching
 
-                if ( ArbActive == 1 ) // ROM mode
-                {
-                    if  ( Index >= ARBINDEXMAX ) break;
-
-                    // Option Multiple Sequence ROM_Array, pick from  selected Sequence
-                    memcpy_P(&tmpArbV, &ArbArrayV_Ptr[Index], sizeof(float));
-                    memcpy_P(&tmpArbT, &ArbArrayT_Ptr[Index], sizeof(uint16_t));
-
-                }
-                else // ( ArbActive == 2 ) // RAM mode
-                {
-                    if  ( Index >= ARBINDEXMAXRAM ) break;
+                if  ( Index >= ARBINDEXMAX ) break;
 
-                    // Option Single Sequence RAM-Array
-                    tmpArbV = ArbV_RAM[Index + ArbRAMOffset];
-                    tmpArbT = ArbT_RAM[Index + ArbRAMOffset];
-                }
+                // Option Multiple Sequence ROM_Array, pick from  selected Sequence
+                tmpArbV = pgm_read_word(&ArbArrayV_Ptr[Index]);
+                memcpy_P(&tmpArbT, &ArbArrayT_Ptr[Index], sizeof(uint16_t));
 
  /*             // to be activated if output shall remain 100% during update of the Arbitrary configuration. However, seeing the update in the waveform is actually fun, too.
                 if (ArbUpdateMode != 0)                 // Workaround for the situations when the array is being modified.
@@ -928,9 +1527,9 @@ void SetLevelDAC(void)
                     Range = 1;
                 }
 
-                if (( Index == 0 ) || ( tmpArbV < ArbMinVoltage ))
+                if (( Index == 0 ) || ( tmpArbV < ArbMinV ))
                 {
-                    ArbMinVoltage = tmpArbV;  // still relative value here
+                    ArbMinV = tmpArbV;  // still relative value here
                 }
 
                 Index++;
@@ -938,7 +1537,7 @@ void SetLevelDAC(void)
             }
             while ( tmpArbT != 0) ;
 
-            ArbMinVoltage *= wVoltage;  // now make absolute value
+            ArbMinVoltage = ArbMinV * wVoltage / 65535.0;  // now make absolute value
         }
         else  // does it make any sense to use the fixed range here? *** not exactly ... tbd
         {
@@ -950,76 +1549,186 @@ void SetLevelDAC(void)
             DCVoltMod = 1; // Prozent-Faktor rcksetzen
         }
 
+        // DAC steps for 100%, scaled by 65536/65535, so the loop below needs no float math.
+        // Limited to 24 bit, points beyond the DAC are clipped one by one by ArbScaleDAC.
+        ArbScale = (uint32_t)(wVoltage * DCVoltMod / DACLSBU[Range] * (65536.0 / 65535.0) + 0.5);
+        if (ArbScale > 0xffffff)
+        {
+            ArbScale = 0xffffff;
+        }
+
+#ifdef ARBTABLE_I
+        // the same for the current, the range has been set above
+        ArbScaleI = (uint32_t)(wCurrent * DCAmpMod / DACLSBI[RangeI] * (65536.0 / 65535.0) + 0.5);
+        if (ArbScaleI > 0xffffff)
+        {
+            ArbScaleI = 0xffffff;
+        }
+
+        SeqI = ArbSelectI;
+        if ( ArbActive == 1 ) // ROM mode
+        {
+            if (SeqI >= ARBSEQUENCECOUNT)
+            {
+                SeqI = ARBSEQUENCECOUNT - 1;
+            }
+            memcpy_P(&ArbArrayVI_Ptr, &ArbArrayV[SeqI], sizeof(const uint16_t *));
+            memcpy_P(&ArbArrayTI_Ptr, &ArbArrayT[SeqI], sizeof(const uint16_t *));
+        }
+        else
+        {
+            if (SeqI >= ArbDirCount)
+            {
+                SeqI = ArbDirCount - 1;
+            }
+            ArbDirGet(SeqI, &DirI);
+        }
+#endif
+
+        // withdraw a bank which has not been taken over by the ISR yet, then fill the bank which is not played.
+        // the ISR keeps on playing its bank (or holds its output with one bank), so no interrupt lock is necessary while filling.
+        sreg = SREG;
+        cli();
+        ArbTableNext = 0;
+#ifdef ARBDOUBLEBANK
+        pArb = (ArbTablePlay == &ArbTable[0]) ? &ArbTable[1] : &ArbTable[0];
+#else
+        pArb = &ArbTable[0];
+        ArbTablePlay = 0;
+#endif
+        SREG = sreg;
+
         Index = 0;
         do
         {
 
             if ( ArbActive == 1 ) // ROM mode
             {
-                if  ( Index >= ARBINDEXMAX ) break;
-
                 // Option Multiple Sequence ROM_Array, pick from  selected Sequence
-                memcpy_P(&tmpArbV, &ArbArrayV_Ptr[Index], sizeof(float));
+                tmpArbV = pgm_read_word(&ArbArrayV_Ptr[Index]);
                 memcpy_P(&tmpArbT, &ArbArrayT_Ptr[Index], sizeof(uint16_t));
 
             }
             else // ( ArbActive == 2 ) // RAM mode
             {
-                if  ( Index >= ARBINDEXMAXRAM ) break;
-
                 // Option Single Sequence RAM-Array
                 tmpArbV = ArbV_RAM[Index + ArbRAMOffset];
                 tmpArbT = ArbT_RAM[Index + ArbRAMOffset];
+
+                if  ( Index + ArbRAMOffset >= ARBINDEXMAXRAM - 1 )
+                {
+                    tmpArbT = 0;                // the end of the array ends the sequence
+                }
             }
 
             if ((Index == 0) && (tmpArbT == 0))     // Workaround for "empty" array (first time value 0) ISR can't handle only one parameter
             {
-                tmpArbV = 1.0;
+                tmpArbV = ARBV(1.0);
             }
             /* to be activated
                     if (ArbUpdateMode != 0)                 // Workaround for the situations when the array is being modified.
                     {
-                        tmpArbV = 1.0;
+                        tmpArbV = ARBV(1.0);
                         tmpArbT = 0;
                     }
             */
-            if  ( Index >= ARBINDEXMAX ) break;
-            // Berechnung des DAC-Wertes fr Spannung
-            tmpDAC = (int32_t)(tmpArbV * wVoltage * DCVoltMod / DACLSBU[Range] + 0.5) + Params.DACUOffsets[Range];
-            if (tmpDAC > DACMax)
+            if  ( Index >= ARBINDEXMAX - 1 )
             {
-                tmpDAC = DACMax;
+                tmpArbT = 0;                    // a longer sequence is cut, the ISR needs the end point in the table
             }
-            else if (tmpDAC < 0)
+
+#ifdef ARBTABLE_I
+            if ( ArbTarget == ARBTARGET_UI )    // current from its own sequence: its times are ignored, its last point is held
             {
-                tmpDAC = 0;
+                if ( ArbActive == 1 )
+                {
+                    tmpArbI = pgm_read_word(&ArbArrayVI_Ptr[IndexI]);
+                    tmpArbTI = pgm_read_word(&ArbArrayTI_Ptr[IndexI]);
+                }
+                else
+                {
+                    tmpArbI = ArbV_RAM[DirI.Start + IndexI];
+                    tmpArbTI = (IndexI + 1 < DirI.Length) ? ArbT_RAM[DirI.Start + IndexI] : 0;
+                }
+                if (tmpArbTI != 0)
+                {
+                    IndexI++;
+                }
+            }
+            else if ( ArbTarget == ARBTARGET_I )
+            {
+                tmpArbI = tmpArbV;
+                tmpArbV = ARBV(1.0);
+            }
+            else
+            {
+                tmpArbI = ARBV(1.0);            // not played, the ISR uses DACRawI
             }
+
+            tmpDACI = ArbScaleDAC(tmpArbI, ArbScaleI, Params.DACIOffsets[RangeI]);
+#endif
+            // Berechnung des DAC-Wertes fr Spannung
+            tmpDAC = ArbScaleDAC(tmpArbV, ArbScale, Params.DACUOffsets[Range]);
             if (((Index == 0) && (tmpArbT == 0)) /* || (ArbUpdateMode != 0)*/)      // Workaround for "empty" array (first time value 0) ISR can't handle only one parameter
             {
-                sreg = SREG;
-                cli();
-                ArbDAC[0] = ArbDAC[1] = tmpDAC;
-                ArbT[0] = ArbT[1] = tmpArbT;
-                RangeU = Range;
-                SREG = sreg;
+                pArb->DAC[0] = pArb->DAC[1] = tmpDAC;
+                pArb->T[0] = pArb->T[1] = tmpArbT;
+                pArb->Unit[0] = pArb->Unit[1] = ARBT_UNIT_MS;
+                pArb->Inc[0] = pArb->Inc[1] = 0;
+#ifdef ARBTABLE_I
+                pArb->DACI[0] = pArb->DACI[1] = tmpDACI;
+                pArb->IncI[0] = pArb->IncI[1] = 0;
+#endif
             }
             else                                    // Regular process
             {
-                sreg = SREG;
-                cli();
-                ArbDAC[Index] = tmpDAC;
-                ArbT[Index] = tmpArbT;
-                RangeU = Range;
-                SREG = sreg;
+                pArb->DAC[Index] = tmpDAC;
+                pArb->T[Index] = tmpArbT & ARBT_COUNTMASK;
+                pArb->Unit[Index] = tmpArbT >> 14;
+                pArb->Inc[Index] = 0;               // final point or unknown yet, updated with the next point
+                if (Index > 0)
+                {
+                    pArb->Inc[Index - 1] = CalcArbSlope(lastArbDAC, tmpDAC, lastArbT);
+                }
+#ifdef ARBTABLE_I
+                pArb->DACI[Index] = tmpDACI;
+                pArb->IncI[Index] = 0;
+                if (Index > 0)
+                {
+                    pArb->IncI[Index - 1] = CalcArbSlope(lastArbDACI, tmpDACI, lastArbT);
+                }
+#endif
             }
 
+            lastArbDAC = tmpDAC;
+#ifdef ARBTABLE_I
+            lastArbDACI = tmpDACI;
+#endif
+            lastArbT = tmpArbT & ARBT_COUNTMASK;   // the slope of the table is per unit, see ArbSlopeMs
             Index++;
 
         }
         while ( tmpArbT != 0) ;
 
+#ifdef ARBTABLE_I
+        pArb->Target = ArbTarget;
+#endif
+
+        // hand over the new bank to the ISR. A range or target change can't wait for the end of the sequence.
         sreg = SREG;
         cli();
+        ArbTableNext = pArb;
+#ifdef ARBDOUBLEBANK
+        ArbSwapAtOnce = (ArbSwapMode == 0) || (Range != RangeU);
+#ifdef ARBTABLE_I
+        if (pArb->Target != ArbTablePlay->Target)
+        {
+            ArbSwapAtOnce = 1;
+        }
+#endif
+#else
+        ArbSwapAtOnce = 1;          // the old sequence is gone already
+#endif
         ArbTrigger = ArbRepeat;
         ArbDelayISR = ArbDelay;
         RangeU = Range;
@@ -1029,6 +1738,175 @@ void SetLevelDAC(void)
 
 //*** End of Code for Arbitrary Mode *************************************************
 
+    lastArbActive = ArbActive;
+    Timer_SelectHandlers();     // waveform source of the mode
+
+    Timer_Profile(PROF_SETLEVELDAC, Timer_Cycles() - ProfStart);
+}
+
+// raw ADC value of x (V or A) for the present range
+static uint16_t CaptureRaw(float x, float LSB, int16_t Offset)
+{
+    float Raw = x / LSB - Offset;
+
+    if (Raw <= 0.0)
+    {
+        return 0;
+    }
+    return (Raw >= 65535.0) ? 0xffff : (uint16_t)Raw;
+}
+
+// levels of the capture trigger for the ISR, before it is armed
+void CaptureCalcLevels(void)
+{
+    if ((CaptureSource >= CAPTURE_SRC_I_RISE) && (CaptureSource <= CAPTURE_SRC_I_WIN))
+    {
+        CaptureRawLow = CaptureRaw(CaptureLevel, ADCLSBI[RangeI], Params.ADCIOffsets[RangeI]);
+        CaptureRawHigh = CaptureRaw(CaptureLevelHigh, ADCLSBI[RangeI], Params.ADCIOffsets[RangeI]);
+    }
+    else
+    {
+        CaptureRawLow = CaptureRaw(CaptureLevel, ADCLSBU[RangeU], Params.ADCUOffsets[RangeU]);
+        CaptureRawHigh = CaptureRaw(CaptureLevelHigh, ADCLSBU[RangeU], Params.ADCUOffsets[RangeU]);
+    }
+}
+
+//*** Statistics of U, I and P, accumulated by the ISR (Timer_StatRead) ***
+static uint8_t  StatRangeU;             // ranges of the running statistics
+static uint8_t  StatRangeI;
+static uint32_t StatCount;              // samples of the last snapshot
+#ifdef STATISTICS
+static float    StatResult[STAT_CHANNELS][STAT_VALUES];     // V, A and W
+#endif
+
+// drops the statistics and starts them with the present ranges, the first Skip values of U are skipped
+void StatRestart(uint8_t Skip)
+{
+    StatRangeU = RangeU;
+    StatRangeI = RangeI;
+    Timer_StatRestart(Params.ADCUOffsets[RangeU], Params.ADCIOffsets[RangeI], Skip);
+}
+
+// Cmd: STAT_CMD_xxx, a snapshot converts the statistics for GetStat and GetStatCount
+void StatSnapshot(uint8_t Cmd)
+{
+    STATS Stats;
+#ifdef STATISTICS
+    float Lsb[STAT_CHANNELS];
+    uint8_t i;
+#endif
+
+    if (Cmd == STAT_CMD_RESTART)
+    {
+        StatRestart(1);
+        return;
+    }
+
+    Timer_StatRead(&Stats, Cmd == STAT_CMD_SNAPRESTART);
+    StatCount = Stats.Count;
+#ifdef STATISTICS
+    Lsb[STAT_U] = ADCLSBU[StatRangeU];
+    Lsb[STAT_I] = ADCLSBI[StatRangeI];
+    Lsb[STAT_P] = Lsb[STAT_U] * Lsb[STAT_I];
+
+    for (i = 0; i < STAT_CHANNELS; i++)
+    {
+        if (Stats.Count == 0)
+        {
+            StatResult[i][STAT_MIN] = StatResult[i][STAT_MAX] = StatResult[i][STAT_MEAN] = StatResult[i][STAT_RMS] = 0.0;
+            continue;
+        }
+        StatResult[i][STAT_MIN] = Stats.Ch[i].Min * Lsb[i];
+        StatResult[i][STAT_MAX] = Stats.Ch[i].Max * Lsb[i];
+        StatResult[i][STAT_MEAN] = (float)Stats.Ch[i].Sum / Stats.Count * Lsb[i];
+        StatResult[i][STAT_RMS] = sqrtf((float)Stats.Ch[i].Sum2 / Stats.Count) * Lsb[i];
+    }
+    StatResult[STAT_P][STAT_RMS] *= 65536.0;       // squares of P >> 16
+#endif
+}
+
+// What: STAT_MIN, STAT_MAX, STAT_MEAN or STAT_RMS of the channel StatSelect in the last snapshot
+float GetStat(uint8_t What)
+{
+#ifdef STATISTICS
+    return StatResult[StatSelect][What];
+#else
+    (void)What;
+    return 0.0;
+#endif
+}
+
+uint32_t GetStatCount(void)
+{
+    return StatCount;
+}
+
+//*** Telemetry, records of U, I and P without polling ***
+// The records are sent in a slot TeleOffset after the sync (a write of 216 or 217) and every TeleInterval
+// after it. With a slot of its own for each device on the bus (default by the address) the records of
+// several devices don't collide, the host sends its commands in the time after the last slot.
+// A record which would be late for its slot is dropped. The crystals of the devices drift apart, the host
+// syncs them again every TELERESYNC seconds. A record is deferred while the answer to a command of this device
+// is sent, up to TELELATE, so the answer doesn't run into the slots of the other devices.
+static uint32_t TeleNext;           // Timer_GetTicker of the next slot
+static uint32_t TeleCmd;            // Timer_GetTicker of the last command, TeleCommand
+static int32_t  TeleLastU;          // values of the last record, for the deadbands
+static int32_t  TeleLastI;
+static uint8_t  TeleQuiet;          // slots without a record
+
+void TeleSync(void)
+{
+    TeleNext = Timer_GetTicker() + (uint32_t)(TeleOffset + TeleInterval) * 10;
+    TeleQuiet = TELEKEEPALIVE;      // the first record regardless of the deadbands
+}
+
+// a command was parsed, its answer is on the bus for up to TELEBUSY
+void TeleCommand(void)
+{
+    TeleCmd = Timer_GetTicker();
+}
+
+void jobTelemetry(void)
+{
+    uint32_t Now;
+    uint32_t Late;
+
+    if (TeleInterval == 0)
+    {
+        return;
+    }
+
+    Now = Timer_GetTicker();
+    if ((int32_t)(Now - TeleNext) < 0)
+    {
+        return;
+    }
+    Late = Now - TeleNext;
+    if ((Late <= TELELATE) && (Now - TeleCmd < TELEBUSY))
+    {
+        return;                     // deferred, the bus is busy with an answer
+    }
+    do
+    {
+        TeleNext += (uint32_t)TeleInterval * 10;    // the phase is kept, slots missed are skipped
+    } while ((int32_t)(Now - TeleNext) >= 0);
+    if (Late > TELELATE)
+    {
+        return;
+    }
+
+    if (((TeleDeadbandU > 0.0) || (TeleDeadbandI > 0.0)) && (++TeleQuiet < TELEKEEPALIVE) &&
+            (labs(xVoltage_uV - TeleLastU) <= TeleDeadbandU * 1e6) &&
+            (labs(xCurrent_10nA - TeleLastI) <= TeleDeadbandI * 1e8))
+    {
+        return;
+    }
+
+    TeleQuiet = 0;
+    TeleLastU = xVoltage_uV;
+    TeleLastI = xCurrent_10nA;
+    TeleSeq++;
+    ParseGetParam(TELESUBCH);
 }
 
 void jobFaultCheck(void)
@@ -1065,11 +1943,11 @@ void jobFaultCheck(void)
 
     uint8_t lowInput = (tmpVolt < 7.0);
 
-    if (xMeanVoltage > (tmpVolt - 2.0))     // Transistor Q12 may be broken?
+    if (GetMeanVoltage() > (tmpVolt - 2.0))     // Transistor Q12 may be broken?
     {
         if (!Status.OverVolt && !lowInput)
         {
-            DPRINT(PSTR("%-10lu Vout: %.2f, Vin: %.2f\n"), Timer_GetTicker(), xMeanVoltage, tmpVolt);
+            DPRINT(PSTR("%-10lu Vout: %.2f, Vin: %.2f\n"), Timer_GetTicker(), GetMeanVoltage(), tmpVolt);
             SerPrompt(FaultErr, Status.u8);
         }
         Status.OverVolt = 1;
@@ -1105,6 +1983,7 @@ void jobSwitchRelay(void)
 {
     static uint8_t RelayTimer = 0;
     static uint8_t CurrentModeCounter = 0;
+    uint8_t Relays = PORTB & ((1<<PB3)|(1<<PB2));
 
     if (PIND & (1<<PD4))
     {
@@ -1143,7 +2022,7 @@ void jobSwitchRelay(void)
         }
     }
                                                                             // Philosophy: kick down if regular (max<=>min) Voltage fits below RelayVoltage
-    if (xMeanVoltage + 0.5 < Params.RelayVoltage - ( ArbActive ? (wVoltage - ArbMinVoltage) : RippleVoltage ) )  // kick-down to lower input voltage in overcurrent and ripple mode 0.5V hysteresis
+    if (GetMeanVoltage() + 0.5 < Params.RelayVoltage - ( ArbActive ? (wVoltage - ArbMinVoltage) : RippleVoltage ) )  // kick-down to lower input voltage in overcurrent and ripple mode 0.5V hysteresis
     {                                                                       // depending on mode: minimum voltage of ripple or arbitrary
         Flags.PwrInRange = 0;
     }                                                                       // to be adapted for arbitrary mode.
@@ -1243,8 +2122,8 @@ void jobSwitchRelay(void)
                         //debug
 
                             printf_P(PSTR("#%d:wVoltage: %.3f\n"), SlaveCh, wVoltage);
-                            printf_P(PSTR("#%d:xVoltage: %.3f\n"), SlaveCh, xVoltage);
-                            printf_P(PSTR("#%d:xMeanVoltage: %.3f\n"), SlaveCh, xMeanVoltage);
+                            printf_P(PSTR("#%d:xVoltage: %.3f\n"), SlaveCh, GetVoltage());
+                            printf_P(PSTR("#%d:xMeanVoltage: %.3f\n"), SlaveCh, GetMeanVoltage());
 
                             printf_P(PSTR("#%d:RippleVoltage: %.3f\n"), SlaveCh, RippleVoltage);
                             printf_P(PSTR("#%d:ArbMinVoltage: %.3f\n"), SlaveCh, ArbMinVoltage);
@@ -1313,6 +2192,11 @@ void jobSwitchRelay(void)
             }
             break;
     }
+
+    if ((PORTB & ((1<<PB3)|(1<<PB2))) != Relays)
+    {
+        Timer_CaptureEvent(CAPTURE_EV_RELAY);
+    }
 }
 
 void SetActivityTimer(uint8_t Value)
@@ -1336,12 +2220,118 @@ void jobActivityTimer(void)
     }
 }
 
+static void job4ms(void)
+{
+    static uint8_t StartTimer = 0;
+
+    PROF_START(uint32_t, Timer_Cycles());
+
+    jobGetValues();
+    Timer_Profile(PROF_GETVALUES, Timer_Cycles() - ProfStart);
+
+    // Funktionen mit 4ms Periode
+
+    if (StartTimer >= 20)
+    {
+#ifdef PROFILING
+        ProfStart = Timer_Cycles();
+#endif
+        jobParseData();
+        Timer_Profile(PROF_PARSE, Timer_Cycles() - ProfStart);
+        jobTelemetry();
+    }
+
+    if (StartTimer < 255)
+    {
+        if (StartTimer == 4)
+        {
+            wVoltage = Params.InitVoltage;
+
+            wStartParamSet = eeprom_read_byte(&StartParamSet);
+
+            if ( 0 != wStartParamSet)
+            {
+                if ((wStartParamSet - 1) == RecallUserParamSet(wStartParamSet - 1, RECALL))
+                    ActiveParamSet = wStartParamSet;
+            }
+
+            ArbActive = ARBACTIVESTART;  // as long as Arbitrary mode is NOT included in Userparams
+
+            CheckLimits();
+            SetLevelDAC();              // Anfangswerte
+            SendTrackCmd();
+            Flags.PwrInRange = 0;
+            g_ucErrCount = 0;
+        }
+        else if (StartTimer == 40)
+        {
+            jobFaultCheck();
+        }
+        StartTimer++;
+    }
+
+    jobSwitchRelay();
+    jobActivityTimer();
+}
+
+static void job100ms(void)
+{
+    static uint8_t ToggleTimer = 0;
+
+    // Funktionen mit 100ms Periode
+    CalcAmpWattHours();
+    jobFaultCheck();
+
+    ToggleTimer ++;
+    if (ToggleTimer == 20)
+    {
+        // toggling display every 2 seconds back and forth
+        ToggleDisplay = 0x01;
+    }
+    else if (ToggleTimer >= 40)
+    {
+        ToggleTimer = 0;
+        ToggleDisplay = 0x00;
+    }
+}
+
+static void job10ms(void)
+{
+    // Funktionen mit 10ms Periode
+}
+
+static void job50ms(void)
+{
+    PROF_START(uint32_t, Timer_Cycles());
+
+    jobPanel();
+    Timer_Profile(PROF_PANEL, Timer_Cycles() - ProfStart);
+}
+
+// Jobs of the main loop by priority. After each job the loop starts again with the first one,
+// so the bus and the measurement wait for one job of the panel or the fault check at most.
+// A job waiting longer than its deadline (100us ticks since its period elapsed, half the period)
+// goes ahead of the jobs within their deadlines, so a busy bus cannot hold off the panel and the
+// fault check until their periods elapse again.
+static const struct
+{
+    uint8_t TimerId;
+    uint16_t Deadline;
+    void (*Job)(void);
+} Jobs[] =
+{
+    {TIMER_4MS,   20,   job4ms},    // jobGetValues, jobParseData, jobTelemetry
+    {TIMER_100MS, 500,  job100ms},  // jobFaultCheck (LM75)
+    {TIMER_50MS,  250,  job50ms},   // jobPanel, LCD and keys
+    {TIMER_10MS,  50,   job10ms},
+};
+
+#define JOBCOUNT    (sizeof(Jobs) / sizeof(Jobs[0]))
+
 //void __attribute__((noreturn)) main(void)
 int main(void)
 {
     uint8_t i;
-    uint8_t StartTimer = 0;
-    uint8_t ToggleTimer = 0;
 
     // Ports initialisieren
     DDRA = 0;
@@ -1377,6 +2367,7 @@ int main(void)
     Timer_Wait_us(20000);
 
     g_ucSlaveCh = ((uint8_t)~PIND) >> 5;
+    TeleOffset = g_ucSlaveCh * TELESLOT;
 
     // I2C initialisieren
     I2C_Init();
@@ -1393,15 +2384,17 @@ int main(void)
     {
         eeprom_read_block(&Params, &eepParams, sizeof(Params));
 
-        eeprom_read_block(ArbV_RAM, ArbV_EEP, sizeof(ArbV_RAM));
-        eeprom_read_block(ArbT_RAM, ArbT_EEP, sizeof(ArbT_RAM));
+        if (!ArbRecall_EEP())
+        {
+            init_Arb_RAMarray();                                        // array of an older firmware, rebuilt
+            ArbSave_EEP();
+        }
     }
     else
     {
         Lcd_Write_P(0, 0, strlen_P(InitEEPStr_P), InitEEPStr_P);
         init_Arb_RAMarray();                                            // write all data first
-        eeprom_write_block(ArbV_RAM, ArbV_EEP, sizeof(ArbV_RAM));
-        eeprom_write_block(ArbT_RAM, ArbT_EEP, sizeof(ArbT_RAM));
+        ArbSave_EEP();
         eeprom_write_byte(&StartParamSet,0);
 
         eeprom_write_block(&Params, &eepParams, sizeof(eepParams));     // last word of Params is the Initialized indicator.
@@ -1474,76 +2467,34 @@ int main(void)
 
     while(1)
     {
-        if (Timer_TestAndResetTimerOV(TIMER_100MS))
+        // the first job past its deadline, else the first job which is due, then again from the top
+        for (i = 0; i < JOBCOUNT; i++)
         {
-            // Funktionen mit 100ms Periode
-            CalcAmpWattHours();
-            jobFaultCheck();
-
-            ToggleTimer ++;
-            if (ToggleTimer == 20)
-            {
-                // toggling display every 2 seconds back and forth
-                ToggleDisplay = 0x01;
-            }
-            else if (ToggleTimer >= 40)
+            if (Timer_TestDeadline(Jobs[i].TimerId, Jobs[i].Deadline))
             {
-                ToggleTimer = 0;
-                ToggleDisplay = 0x00;
+                break;
             }
         }
-        if (Timer_TestAndResetTimerOV(TIMER_50MS))
-        {
-            // Funktionen mit 50ms Periode
-            jobPanel();
-        }
-        if (Timer_TestAndResetTimerOV(TIMER_10MS))
+        if (i < JOBCOUNT)
         {
-            // Funktionen mit 10ms Periode
+            Timer_TestAndResetTimerOV(Jobs[i].TimerId);
+            Jobs[i].Job();
+            continue;
         }
-        if (Timer_TestAndResetTimerOV(TIMER_4MS))
-        {
-            jobGetValues();
-
-            // Funktionen mit 4ms Periode
-
-            if (StartTimer >= 20)
-            {
-                jobParseData();
-            }
 
-            if (StartTimer < 255)
+        for (i = 0; i < JOBCOUNT; i++)
+        {
+            if (Timer_TestAndResetTimerOV(Jobs[i].TimerId))
             {
-                if (StartTimer == 4)
-                {
-                    wVoltage = Params.InitVoltage;
-
-                    wStartParamSet = eeprom_read_byte(&StartParamSet);
-
-                    if ( 0 != wStartParamSet)
-                    {
-                        if ((wStartParamSet - 1) == RecallUserParamSet(wStartParamSet - 1, RECALL))
-                            ActiveParamSet = wStartParamSet;
-                    }
-
-                    ArbActive = ARBACTIVESTART;  // as long as Arbitrary mode is NOT included in Userparams
-
-                    CheckLimits();
-                    SetLevelDAC();              // Anfangswerte
-                    SendTrackCmd();
-                    Flags.PwrInRange = 0;
-                    g_ucErrCount = 0;
-                }
-                else if (StartTimer == 40)
-                {
-                    jobFaultCheck();
-                }
-                StartTimer++;
+                Jobs[i].Job();
+                break;
             }
-
-            jobSwitchRelay();
-            jobActivityTimer();
         }
+        if (i < JOBCOUNT)
+        {
+            continue;
+        }
+
         sleep_enable();
         sleep_cpu();
         sleep_disable();
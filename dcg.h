@@ -21,6 +21,7 @@
 #define __DCG_H__
 
 #include <inttypes.h>
+#include <avr/io.h>
 #include <avr/eeprom.h>
 
 #include "config.h"
@@ -143,17 +144,15 @@ extern PARAMS eepParams EEMEM;
 extern float DCVoltMod;
 extern float DCAmpMod;
 extern float Temperature;
-extern float xVoltage;
-extern float xVoltageLow;
-extern float xCurrent;
-extern float xCurrentLow;
-extern float xPower;
-extern float xPowerTot;
+extern int32_t xVoltage_uV;
+extern int32_t xVoltageLow_uV;
+extern int32_t xCurrent_10nA;
+extern int32_t xCurrentLow_10nA;
 extern float xAmpHours;
 extern float xWattHours;
 
-extern float xMeanVoltage;
-extern float xMeanCurrent;
+extern int32_t xMeanVoltage_uV;
+extern int32_t xMeanCurrent_10nA;
 
 extern float wVoltage;
 extern float wCurrent;
@@ -162,6 +161,18 @@ extern uint16_t ADCRawU;
 extern uint16_t ADCRawULow;
 extern uint16_t ADCRawI;
 extern uint16_t ADCRawILow;
+extern uint8_t  ADCSamples;
+extern uint8_t  SHRefresh;
+extern uint8_t  WaveTicks;
+extern uint8_t  StatSelect;
+extern int16_t  TeleInterval;
+extern int16_t  TeleOffset;
+extern float    TeleDeadbandU;
+extern float    TeleDeadbandI;
+extern uint8_t  TeleSeq;
+extern float    CaptureLevel;
+extern float    CaptureLevelHigh;
+extern uint16_t DACSkipped;
 extern uint16_t DACRawU;
 extern uint16_t DACRawI;
 
@@ -197,14 +208,64 @@ extern char g_cSerInpStr[];
 
 extern uint16_t RippleActive;
 
+//*** Telemetry records, jobTelemetry *********************************
+
+#define TELESUBCH           220     // SubCh of the records
+#define TELESLOT            16      // ms, default slot per address: a record of 39 characters takes 10ms at 38400 Bd
+#define TELELATE            40      // 100us, 4ms, a record later in its slot is dropped
+#define TELEBUSY            100     // 100us, 10ms after a command the answer may still be on the bus
+#define TELERESYNC          10      // s, the host syncs again: 4ms in 10s are 400ppm between the crystals
+#define TELEINTERVALMIN     20      // ms
+#define TELEINTERVALMAX     30000
+#define TELEKEEPALIVE       50      // with the deadbands a record every 50 intervals at least
+
 //*** Arbitrary Mode variables/constants/functions *********************
 
-extern uint16_t   ArbDAC[];
-extern uint16_t   ArbT[];
+// The buffers of the arbitrary modes are sized by the RAM of the target (RAMEND):
+// 2 KB (ATmega32, ATmega324P), 4 KB (ATmega644, ATmega644P) and 16 KB (ATmega1284P).
+#define ARBINDEXMAX 50
+
+#if (RAMEND >= 0x4000)
+#define ARBDOUBLEBANK       // second table bank, filled while the first one is played. Without it the output
+                            // holds while SetLevelDAC fills the only bank, and 190 has no effect
+#endif
+
+#define ARBTARGET_U     0   // the sequence is played on the voltage DAC
+#define ARBTARGET_I     1   // the sequence is played on the current DAC, the voltage is static
+#define ARBTARGET_UI    2   // voltage and current sequences are played in lockstep with the times of the voltage sequence
+
+#if defined(DUAL_DAC) && !defined(DEBUGSTDHW)
+#define WAVETICK            // waveform tick below 1ms by Timer1, see WaveTicks
+#endif
+
+#if (RAMEND >= 0x1000)
+#define ARBTABLE_I          // second DAC table for the current, not enough RAM with 2 KB
+#define ARBTARGETMAX    ARBTARGET_UI
+#else
+#define ARBTARGETMAX    ARBTARGET_U
+#endif
+
+typedef struct
+{
+    uint16_t DAC[ARBINDEXMAX];      // DAC in raw values
+    uint16_t T[ARBINDEXMAX];        // Duration in units of Unit
+    uint8_t  Unit[ARBINDEXMAX];     // ARBT_UNIT_xxx, the ISR counts the ms of a unit with a prescaler
+    uint32_t Inc[ARBINDEXMAX];      // Slope in DAC steps per unit of the step, 16.16 fixed point (two's complement for falling slopes)
+#ifdef ARBTABLE_I
+    uint16_t DACI[ARBINDEXMAX];     // current DAC in raw values, same times as the voltage
+    uint32_t IncI[ARBINDEXMAX];     // slope of the current, see Inc
+    uint8_t  Target;                // ARBTARGET_xxx, changes together with the bank
+#endif
+} ARBTABLE;
+
+extern ARBTABLE*  ArbTablePlay;
+extern ARBTABLE*  ArbTableNext;
+extern uint8_t    ArbSwapAtOnce;
 extern const char PROGMEM* const PROGMEM ArbArrayL[];
 
 extern uint8_t  ArbActive;
 extern uint8_t  ArbSelect;
+extern uint8_t  ArbSwapMode;
 
 extern uint8_t  ArbRepeat;
 extern uint8_t  ArbTrigger;
@@ -216,19 +277,157 @@ extern int16_t  ArbDelayISR;
 extern uint8_t ArbSelectRAM;
 extern uint8_t ArbRAMOffset;
 
+extern uint8_t ArbTarget;
+extern uint8_t ArbSelectI;
+
+#if (RAMEND < 0x1000)
 #define ARBINDEXMAXRAM 75
+#else
+#define ARBINDEXMAXRAM 150
+#endif
+
+#define ARBEEPLAYOUT    2   // layout of the array in EEPROM: 16 bit values and time units, ARBINDEXMAXRAM points
+
+// relative voltages 0.0..1.0 are stored as 0..65535 (Q0.16) in the RAM/EEPROM/ROM arrays
+#define ARBV(v) ((uint16_t)((v) * 65535.0 + 0.5))
+
+// time values of the RAM/EEPROM/ROM arrays: bits 15..14 = unit, bits 13..0 = count of units, 0 = end of sequence
+#define ARBT_UNIT_MS        0       // 1 ms, up to 16.383 s
+#define ARBT_UNIT_100MS     1       // 100 ms, up to 27 min
+#define ARBT_UNIT_S         2       // 1 s, up to 4.5 h
+#define ARBT_UNIT_MIN       3       // 1 min, up to 273 h
+#define ARBT_COUNTMASK      0x3fff
+#define ARBT(count, unit)   ((uint16_t)(((uint16_t)(unit) << 14) | (count)))
 
-extern float   ArbV_RAM[ARBINDEXMAXRAM];
+extern const uint16_t ArbUnitMs[4];
+extern uint16_t ArbTimeEncode(uint16_t T, uint8_t Unit);
+extern uint32_t ArbTimeMs(uint16_t T);
+
+extern uint16_t ArbV_RAM[ARBINDEXMAXRAM];
 extern uint16_t ArbT_RAM[ARBINDEXMAXRAM];
 
-extern float   ArbV_EEP[ARBINDEXMAXRAM]  EEMEM;
+extern uint16_t ArbV_EEP[ARBINDEXMAXRAM]  EEMEM;
 extern uint16_t ArbT_EEP[ARBINDEXMAXRAM]  EEMEM;
 
 extern uint8_t  ArbUpdateMode;
 extern float   ArbRAMtmpV;
 extern uint16_t ArbRAMtmpT;
+extern uint8_t  ArbRAMtmpTUnit;
+
+// Directory of the sequences in the RAM array, built once when the array has changed.
+// It holds the first ARBDIRMAX sequences, the further ones are scanned when they are selected (ArbDirGet).
+#define ARBDIRMAX 8
 
+typedef struct
+{
+    uint8_t Start;      // index of the first point in the RAM array
+    uint8_t Length;     // number of points incl. the end point (time value 0)
+    uint16_t Min;       // lowest relative voltage (see ARBV), for the relay switching
+    uint16_t Max;       // highest relative voltage, range hint: range 1 if Max * dcv > MaxVoltage[0]
+} ARBDIR;
+
+extern ARBDIR   ArbDir[ARBDIRMAX];
+extern uint8_t  ArbDirCount;
+
+extern void ArbDirBuild(void);
+extern void ArbDirGet(uint8_t, ARBDIR*);
+extern void ArbSave_EEP(void);
+extern uint8_t ArbRecall_EEP(void);
 extern uint8_t get_SequenceStart_RAMarray(uint8_t*);
+extern uint32_t CalcArbSlope(uint16_t, uint16_t, uint32_t);
+
+// Streaming (ArbActive = 3), ring buffer of segments, the size must be a power of 2
+#if (RAMEND < 0x1000)
+#define ARBSTREAMSIZE 8
+#elif (RAMEND < 0x4000)
+#define ARBSTREAMSIZE 16
+#else
+#define ARBSTREAMSIZE 64
+#endif
+
+typedef struct
+{
+    uint16_t DAC[ARBSTREAMSIZE];    // start value of the segment, DAC raw value
+    uint16_t T[ARBSTREAMSIZE];      // duration in ms, 0 = end of stream
+    uint32_t Inc[ARBSTREAMSIZE];    // slope, see ARBTABLE
+    uint8_t  Head;                  // next segment to be written, only changed by ArbStreamPut
+    uint8_t  Tail;                  // segment played, only changed by the ISR
+    uint8_t  Playing;               // ISR: 1 = segment Tail is played, 0 = start segment Tail when available
+    uint16_t Hold;                  // ISR: output value if no segment is available
+} ARBSTREAM;
+
+extern ARBSTREAM ArbStream;
+extern uint16_t ArbStreamUnderrun;
+
+extern void ArbStreamReset(void);
+extern uint8_t ArbStreamPut(float, uint16_t);
+extern uint8_t GetArbStreamLevel(void);
+
+// Function generator (ArbActive = 4), waveforms calculated by the ISR with a phase accumulator
+#define ARBFUNC_SINE        0
+#define ARBFUNC_TRIANGLE    1
+#define ARBFUNC_SAWTOOTH    2
+#define ARBFUNC_SQUARE      3
+#define ARBFUNC_EXP         4
+
+typedef struct
+{
+    uint32_t PhaseInc;      // phase increment per ms, 2^32 = one period
+    uint32_t RiseScale;     // 65535 / Duty in 16.16 fixed point, for the rising part
+    uint32_t FallScale;     // 65535 / (1 - Duty) in 16.16 fixed point, for the falling part
+    uint16_t Duty;          // phase (upper 16 bits) of the end of the rising part
+    uint16_t DACLow;        // DAC value of the lowest level
+    uint16_t DACSpan;       // DAC difference between the highest and the lowest level
+    uint8_t  Shape;         // ARBFUNC_xxx
+} ARBFUNC;
+
+// Program (ArbActive = 5), instructions interpreted by the ISR
+#define ARBOP_END       0   // stop, hold the level
+#define ARBOP_SEG       1   // linear segment from the current level to V within T ms
+#define ARBOP_HOLD      2   // hold the current level for T ms
+#define ARBOP_LOOP      3   // repeat the instructions up to the next ARBOP_NEXT Arg times (0 = endless)
+#define ARBOP_NEXT      4   // end of loop
+#define ARBOP_JUMP      5   // continue with instruction Arg
+#define ARBOP_WAIT      6   // wait for a trigger (SubCh 117)
+#define ARBOP_SETI      7   // set the current limit to V (relative to dca)
+
+#if (RAMEND < 0x1000)
+#define ARBPRGMAX       8
+#elif (RAMEND < 0x4000)
+#define ARBPRGMAX       16
+#else
+#define ARBPRGMAX       32
+#endif
+#define ARBPRGLOOPS     4   // max. nesting of loops
+
+typedef struct
+{
+    uint8_t  Op;        // ARBOP_xxx
+    uint8_t  Arg;       // loop count, jump target
+    uint16_t V;         // relative voltage/current, see ARBV
+    uint16_t T;         // duration in ms
+} ARBINSTR;
+
+typedef struct
+{
+    uint16_t DAC;       // V converted to a DAC value of the current range
+    uint32_t Recip;     // 2^32 / T, the ISR calculates the slope with a multiplication
+} ARBINSTRLINK;
+
+extern ARBINSTR     ArbPrg[ARBPRGMAX];
+extern ARBINSTRLINK ArbPrgLink[2][ARBPRGMAX];
+extern ARBINSTRLINK* ArbPrgLinkPlay;
+extern uint16_t     ArbPrgStartDAC;
+extern uint8_t      ArbPrgRestart;
+extern uint8_t      ArbPrgTrigger;
+extern uint8_t      ArbPrgPC;
+
+extern ARBFUNC  ArbFuncISR;
+extern uint8_t  ArbFuncShape;
+extern float    ArbFuncFreq;
+extern float    ArbFuncAmp;
+extern float    ArbFuncOffset;
+extern uint8_t  ArbFuncDuty;
 
 //*** Arbitrary Mode variables/constants/functions *********************
 
@@ -236,9 +435,25 @@ extern uint8_t get_SequenceStart_RAMarray(uint8_t*);
 
 // dcg.c //////////////////////////////////////////////////
 float GetPowerIn(void);
+float GetVoltage(void);
+float GetVoltageLow(void);
+float GetCurrent(void);
+float GetCurrentLow(void);
+float GetMeanVoltage(void);
+float GetMeanCurrent(void);
+float GetPower(void);
+float GetPowerTot(void);
 void InitScales(void);
 void SetLevelDAC(void);
 void CheckLimits(void);
+void CaptureCalcLevels(void);
+void StatRestart(uint8_t Skip);
+void StatSnapshot(uint8_t Cmd);
+float GetStat(uint8_t What);
+uint32_t GetStatCount(void);
+void TeleSync(void);
+void TeleCommand(void);
+void jobTelemetry(void);
 uint8_t CalcRangeI(float);
 void SetActivityTimer(uint8_t);
 
@@ -23,26 +23,46 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <util/delay.h>
+#include <util/delay_basic.h>
 #include <avr/pgmspace.h>
+#include <string.h>
 
 #include "timer.h"
 #include "dcg.h"
 #include "Encoder.h"
 #include "config.h"
 
-static volatile struct
-{
-    uint8_t Timer4msOV      : 1;
-    uint8_t Timer10msOV     : 1;
-    uint8_t Timer50msOV     : 1;
-    uint8_t Timer100msOV    : 1;
-    uint8_t TimersActive    : 1;
-} TimerFlags;
+// jobs of the main loop, bit in TimerPending and index of the statistics
+#define TIMER_JOB_4MS       0
+#define TIMER_JOB_10MS      1
+#define TIMER_JOB_50MS      2
+#define TIMER_JOB_100MS     3
+
+static volatile uint8_t TimerPending;       // period of the job elapsed, job not started yet
+static uint8_t TimersActive;
+static uint16_t TimerReady[TIMER_JOBS];     // Timer_GetTicker (low word) when the period elapsed
 
-static volatile uint32_t Ticker;
+int16_t SchedLatencyMax[TIMER_JOBS];        // for Parameter 60..63, max. time from the end of the period to the start of the job in 100us
+int16_t SchedOverruns[TIMER_JOBS];          // for Parameter 64..67, periods elapsed again before the job was started
+uint8_t ProfSelect;                         // for Parameter 120, profile read by 121..125
+
+static volatile uint32_t Timer2Slots;   // 500us slots of Timer2, the time base of Timer_GetTicker
+static volatile uint16_t Timer1Ovf;     // upper word of Timer_Cycles
 static uint8_t TimerState;
 
+#if !defined(__AVR_ATmega32__)
+#define TIMER2_SUBSTATES            // waits within a Timer2 slot by compare unit B, see TIMER2_COMPB_vect
+#endif
+
+// Timer2 ticks for at least us microseconds, prescaler 64 above 16MHz else 32, +1 for the running tick
+#if (F_CPU > 16000000UL)
+#define T2SUB_COUNTS(us)    ((uint8_t)((us) * (F_CPU / 1000000UL) / 64 + 1))
+#else
+#define T2SUB_COUNTS(us)    ((uint8_t)((us) * (F_CPU / 1000000UL) / 32 + 1))
+#endif
+
 static uint8_t TimeBase4ms;
+static uint16_t DACLastOut;         // value last shifted to the (voltage) DAC, see Timer_BenchDAC
 static uint8_t TimeBase10ms;
 static uint8_t TimeBase100ms;
 
@@ -51,23 +71,34 @@ void Timer_Init(void)
     uint8_t sreg = SREG;
     cli();
 
-    // initialize Timer 0, period 100us, prescaler 8, CTC mode, up to 20MHz
+    // initialize Timer 0, period 500us, prescaler 64, CTC mode, up to 20MHz, for the encoder only
+    // started half a period after Timer 2, so it ticks in the middle of the Timer 2 slots
 #if defined(__AVR_ATmega32__)
-    OCR0 = (F_CPU / 80000UL) - 1;
-    TCNT0 = 0;
-    TCCR0 = (1<<WGM01)|(1<<CS01);
-    TIMSK = (1<<OCIE0);
+    OCR0 = (F_CPU / 128000UL) - 1;
+    TCNT0 = (F_CPU / 256000UL);
+    TCCR0 = (1<<WGM01)|(1<<CS01)|(1<<CS00);
+    TIMSK |= (1<<OCIE0);
 #elif defined(__AVR_ATmega324P__) || defined(__AVR_ATmega644__) || defined(__AVR_ATmega644P__) || defined(__AVR_ATmega1284P__)
-    OCR0A = (F_CPU / 80000UL) - 1;
+    OCR0A = (F_CPU / 128000UL) - 1;
     OCR0B = 0;
-    TCNT0 = 0;
-    TCCR0A = (1<<WGM01);;
-    TCCR0B = (1<<CS01);
+    TCNT0 = (F_CPU / 256000UL);
+    TCCR0A = (1<<WGM01);
+    TCCR0B = (1<<CS01)|(1<<CS00);
     TIMSK0 = (1<<OCIE0A);
 #else
 #error Please define your TIMER0 code
 #endif
 
+    // Timer 1 runs free at F_CPU for Timer_Cycles, the overflow interrupt extends it to 32 bit
+    TCCR1A = 0;
+    TCNT1 = 0;
+    TCCR1B = (1<<CS10);
+#if defined(__AVR_ATmega32__)
+    TIMSK |= (1<<TOIE1);
+#else
+    TIMSK1 = (1<<TOIE1);
+#endif
+
     // Timer 2
 #if defined(__AVR_ATmega32__)
 #if (F_CPU > 16000000UL)
@@ -106,7 +137,7 @@ void Timer_Init(void)
 #endif
 
 
-    TimerFlags.TimersActive = 0;
+    TimersActive = 0;
 
     SREG = sreg;
 }
@@ -114,161 +145,1700 @@ void Timer_Init(void)
 
 
 
-#if defined(__AVR_ATmega32__)
-ISR(TIMER0_COMP_vect)
-#elif defined(__AVR_ATmega324P__) || defined(__AVR_ATmega644__) || defined(__AVR_ATmega644P__) || defined(__AVR_ATmega1284P__)
-ISR(TIMER0_COMPA_vect)
-#else
-#error Please define your TIMER0 code
+
+//*** Capture of the ADC values (scope mode) ***
+// Armed by Timer_CaptureControl, every CaptureDecimation-th value of U is stored together with the last
+// value of I in a ring buffer, so a sample is taken every 2ms * CaptureDecimation. After CapturePre samples
+// an event of CaptureSource triggers, CapturePost samples later the record is complete and kept until the
+// capture is armed again. The trigger is at sample Timer_CaptureTrigger of the record.
+int16_t CapturePre = 16;                    // for Parameter 130, samples before the trigger
+int16_t CapturePost = 48;                   // for Parameter 131, samples from the trigger on
+uint8_t CaptureDecimation = 1;              // for Parameter 132, sample every n-th value of U
+uint8_t CaptureSource;                      // for Parameter 133, CAPTURE_SRC_xxx
+uint16_t CaptureRawLow;                     // level of the threshold sources as raw ADC value, see CaptureCalcLevels
+uint16_t CaptureRawHigh;                    // upper level of the window
+
+static volatile uint8_t CaptureState;       // CAPTURE_xxx
+
+#ifdef CAPTURE
+typedef struct
+{
+    uint16_t U;
+    uint16_t I;
+} CAPTURESAMPLE;
+
+static CAPTURESAMPLE CaptureBuf[CAPTURESIZE];
+static uint16_t CaptureHead;                // next sample to write
+static uint16_t CaptureFilled;              // samples since armed, up to CAPTURESIZE
+static uint16_t CaptureLeft;                // samples after the trigger still to take
+static uint16_t CaptureTrig;                // samples before the trigger in the record
+static uint16_t CaptureCnt;                 // samples in the complete record
+static uint16_t CapturePreISR;              // parameters of the running capture
+static uint16_t CapturePostISR;
+static uint8_t  CaptureSourceISR;
+static uint8_t  CaptureDecimISR;
+static uint8_t  CaptureDecimCnt;
+static uint8_t  CaptureMaskISR;             // CAPTURE_EV_xxx of the source
+static uint16_t CaptureLowISR;
+static uint16_t CaptureHighISR;
+static uint16_t CaptureI;                   // last value of I
+static uint16_t CapturePrevU;               // value before, for the thresholds
+static uint16_t CapturePrevI;
+static uint8_t  CaptureEvent;               // events since the last sample, CAPTURE_EV_xxx
+static uint32_t CaptureTime;                // Timer2Slots at the trigger
 #endif
+
+// trigger event, called by the interrupts of the waveform
+static inline void CaptureEventSet(uint8_t Event)
 {
-    Ticker++;
+#ifdef CAPTURE
+    CaptureEvent |= Event;
+#endif
 }
 
+// threshold and window of the trigger source on every value of U (SlotU != 0) or I
+static inline void CaptureCheckLevel(uint16_t Value, uint8_t SlotU)
+{
+#ifdef CAPTURE
+    uint8_t Src = CaptureSourceISR;
+    uint16_t Prev;
+
+    if (SlotU)
+    {
+        Prev = CapturePrevU;
+        CapturePrevU = Value;
+        Src -= CAPTURE_SRC_U_RISE;
+    }
+    else
+    {
+        Prev = CapturePrevI;
+        CapturePrevI = Value;
+        Src -= CAPTURE_SRC_I_RISE;
+    }
 
+    switch (Src)
+    {
+        case 0:                 // rising, CAPTURE_SRC_x_RISE
+            if ((Prev >= CaptureLowISR) || (Value < CaptureLowISR))
+                return;
+            break;
 
+        case 1:                 // falling
+            if ((Prev <= CaptureLowISR) || (Value > CaptureLowISR))
+                return;
+            break;
 
+        case 2:                 // leaving the window
+            if (((Prev < CaptureLowISR) || (Prev > CaptureHighISR)) ||
+                    ((Value >= CaptureLowISR) && (Value <= CaptureHighISR)))
+                return;         // outside already or still inside
+            break;
 
-#if defined(__AVR_ATmega32__)
-ISR(TIMER2_COMP_vect)
-#elif defined(__AVR_ATmega324P__) || defined(__AVR_ATmega644__) || defined(__AVR_ATmega644P__) || defined(__AVR_ATmega1284P__)
-ISR(TIMER2_COMPA_vect)
-#else
-#error Please define your TIMER2 code
+        default:
+            return;             // other channel or no level source
+    }
+    CaptureEvent |= CAPTURE_EV_LEVEL;
 #endif
+}
+
+// value of U (SlotU != 0) or I, called by ADCStore
+static inline void CaptureStore(uint16_t Value, uint8_t SlotU)
 {
-    static uint8_t lastRangeU = 0xff;
-    static uint8_t stateRangeU = 0xff;
-    static uint8_t lastRangeI = 0xff;
-    static uint8_t stateRangeI = 0xff;
-#ifdef DUAL_DAC
-    static uint16_t lastUDACOut = 0xffff;
-    static uint16_t lastIDACOut = 0xffff;
+#ifdef CAPTURE
+    uint8_t Event, sreg;
+
+    if ((CaptureState != CAPTURE_ARMED) && (CaptureState != CAPTURE_TRIGGERED))
+    {
+        return;
+    }
+    CaptureCheckLevel(Value, SlotU);
+    if (!SlotU)
+    {
+        CaptureI = Value;
+        return;
+    }
+    if (++CaptureDecimCnt < CaptureDecimISR)
+    {
+        return;
+    }
+    CaptureDecimCnt = 0;
+
+    sreg = SREG;
+    cli();                  // events of the waveform tick and the main loop
+    Event = CaptureEvent;
+    CaptureEvent = 0;
+    SREG = sreg;
+
+    CaptureBuf[CaptureHead].U = Value;
+    CaptureBuf[CaptureHead].I = CaptureI;
+    CaptureHead = (CaptureHead + 1) & (CAPTURESIZE - 1);
+    if (CaptureFilled < CAPTURESIZE)
+    {
+        CaptureFilled++;
+    }
+
+    if (CaptureState == CAPTURE_ARMED)
+    {
+        // the event happened before this sample, so it is the first one after the trigger
+        if ((Event & CAPTURE_EV_MANUAL) ||
+                ((Event & CaptureMaskISR) && (CaptureFilled > CapturePreISR)))
+        {
+            CaptureTime = Timer2Slots;
+            CaptureTrig = (CaptureFilled - 1 < CapturePreISR) ? CaptureFilled - 1 : CapturePreISR;
+            CaptureCnt = CaptureTrig + CapturePostISR;
+            CaptureLeft = CapturePostISR - 1;
+            CaptureState = CaptureLeft ? CAPTURE_TRIGGERED : CAPTURE_DONE;
+        }
+    }
+    else if (--CaptureLeft == 0)
+    {
+        CaptureState = CAPTURE_DONE;
+    }
 #endif
-    uint8_t i;
+}
 
-    typedef union
+#ifdef CAPTURE
+// value before the first one, which doesn't fire the level source
+static uint16_t CaptureNoEdge(uint8_t Source)
+{
+    switch (Source)
     {
-        uint32_t u32;
-        uint16_t u16;
-    } Values;
+        case CAPTURE_SRC_U_RISE:
+        case CAPTURE_SRC_I_RISE:
+            return 0xffff;
 
-#ifdef DUAL_DAC
-    typedef struct
+        case CAPTURE_SRC_U_WIN:
+        case CAPTURE_SRC_I_WIN:
+            return CaptureRawLow ? 0 : 0xffff;      // outside: below the window, or above it if it starts at 0
+
+        default:
+            return 0;
+    }
+}
+#endif
+
+// Cmd: CAPTURE_CMD_xxx, arming takes the parameters and drops the record before
+void Timer_CaptureControl(uint8_t Cmd)
+{
+#ifdef CAPTURE
+    uint8_t sreg = SREG;
+    cli();
+
+    switch (Cmd)
     {
-        uint16_t U;
-        uint16_t I;
-    } DACData;
+        case CAPTURE_CMD_ARM:
+            CapturePreISR = CapturePre;
+            CapturePostISR = CapturePost;
+            CaptureSourceISR = CaptureSource;
+            CaptureDecimISR = CaptureDecimation;
+            CaptureDecimCnt = CaptureDecimation - 1;     // first sample at once
+            CaptureLowISR = CaptureRawLow;
+            CaptureHighISR = CaptureRawHigh;
+            CapturePrevU = CapturePrevI = CaptureNoEdge(CaptureSource);
+            switch (CaptureSource)
+            {
+                case CAPTURE_SRC_ARB:
+                    CaptureMaskISR = CAPTURE_EV_ARB;
+                    break;
 
-    static DACData DACOut =
+                case CAPTURE_SRC_RIPPLE:
+                    CaptureMaskISR = CAPTURE_EV_RIPPLE;
+                    break;
+
+                case CAPTURE_SRC_RELAY:
+                    CaptureMaskISR = CAPTURE_EV_RELAY;
+                    break;
+
+                case CAPTURE_SRC_MANUAL:
+                    CaptureMaskISR = 0;
+                    break;
+
+                default:
+                    CaptureMaskISR = CAPTURE_EV_LEVEL;
+                    break;
+            }
+            CaptureHead = CaptureFilled = 0;
+            CaptureEvent = 0;
+            CaptureState = CAPTURE_ARMED;
+            break;
+
+        case CAPTURE_CMD_TRIGGER:
+            CaptureEvent |= CAPTURE_EV_MANUAL;
+            break;
+
+        default:
+            CaptureState = CAPTURE_IDLE;
+            break;
+    }
+
+    SREG = sreg;
+#else
+    (void)Cmd;
+#endif
+}
+
+// trigger event of the main loop, CAPTURE_EV_xxx
+void Timer_CaptureEvent(uint8_t Event)
+{
+#ifdef CAPTURE
+    uint8_t sreg = SREG;
+    cli();
+    CaptureEvent |= Event;
+    SREG = sreg;
+#else
+    (void)Event;
+#endif
+}
+
+uint8_t Timer_CaptureState(void)
+{
+    return CaptureState;
+}
+
+// time of the trigger in the units of Timer_GetTicker, 0 until the record is complete
+uint32_t Timer_CaptureTime(void)
+{
+#ifdef CAPTURE
+    return (CaptureState == CAPTURE_DONE) ? CaptureTime * 5 : 0;
+#else
+    return 0;
+#endif
+}
+
+// samples in the record, 0 until it is complete
+int16_t Timer_CaptureCount(void)
+{
+#ifdef CAPTURE
+    return (CaptureState == CAPTURE_DONE) ? CaptureCnt : 0;
+#else
+    return 0;
+#endif
+}
+
+// sample of the record which is the first one after the trigger
+int16_t Timer_CaptureTrigger(void)
+{
+#ifdef CAPTURE
+    return (CaptureState == CAPTURE_DONE) ? CaptureTrig : 0;
+#else
+    return 0;
+#endif
+}
+
+// sample Index of the complete record, in time order. Returns 0 beyond its end.
+uint8_t Timer_CaptureRead(uint16_t Index, uint16_t* pU, uint16_t* pI)
+{
+#ifdef CAPTURE
+    CAPTURESAMPLE* p;
+
+    if ((CaptureState != CAPTURE_DONE) || (Index >= CaptureCnt))
     {
-        .U = 0,
-        .I = 0,
-    };
+        return 0;
+    }
+    p = &CaptureBuf[(CaptureHead - CaptureCnt + Index) & (CAPTURESIZE - 1)];
+    *pU = p->U;
+    *pI = p->I;
+    return 1;
+#else
+    return 0;
 #endif
+}
 
-    static Values Value;
 
-// Ripple Values (internal to ISR)
-    static uint8_t TimeRippleLow = 0;
-    static uint8_t RippleModeOn = 0;
-    static int16_t RippleTicker = 0;
+//*** Statistics of U, I and P (U * I) ***
+// Every value of U and the last value of I, both + the offset of the range, are accumulated to the min, max,
+// sum and sum of the squares of the channels. After StatWindow samples the window is complete, it is kept
+// for Timer_StatRead and the next one starts. With StatWindow = 0 the samples are accumulated until the
+// statistics are read with a restart.
+int16_t StatWindow = 500;                   // for Parameter 143, samples (2ms) of a window, 0 = until restarted
 
-    static uint8_t  RippleLowToHighU = 0;
-    static uint8_t  RippleHighToLowU = 0;
+#ifdef STATISTICS
+static STATS StatAcc;                       // running window
+static STATS StatDone;                      // last complete window, Count = 0 if none yet
+static uint16_t StatWindowISR;
+static int16_t  StatOffsetU;
+static int16_t  StatOffsetI;
+static uint8_t  StatSkip;                   // values of U to skip, after a range switch
+static uint16_t StatI;                      // last value of I + offset
+
+static void StatStart(void)
+{
+    uint8_t i;
 
-    static uint8_t  RippleLowToHighI = 0;
-    static uint8_t  RippleHighToLowI = 0;
+    StatAcc.Count = 0;
+    for (i = 0; i < STAT_CHANNELS; i++)
+    {
+        StatAcc.Ch[i].Min = 0xffffffff;
+        StatAcc.Ch[i].Max = 0;
+        StatAcc.Ch[i].Sum = 0;
+        StatAcc.Ch[i].Sum2 = 0;
+    }
+}
 
+static inline void StatAdd(STATACC* p, uint32_t Value, uint32_t Square)
+{
+    if (Value < p->Min)
+    {
+        p->Min = Value;
+    }
+    if (Value > p->Max)
+    {
+        p->Max = Value;
+    }
+    p->Sum += Value;
+    p->Sum2 += Square;
+}
 
-// Arbitrary Values (internal to ISR)
-    static uint8_t ArbIndex = 0; // Index in the Array
-    static uint16_t ArbTmr = 0; // Timer for Ticks
-    static uint16_t ArbDlyTmr = 0; // Delay Timer for Ticks
+// raw value + offset, limited to 0..0xffff
+static inline uint16_t StatValue(uint16_t Value, int16_t Offset)
+{
+    int32_t v = (int32_t)Value + Offset;
 
-// for debugging standard hardware on Dual-DAC hardware
-#ifdef DEBUGSTDHW
-    static uint8_t ArbToggle=0;
+    return (v <= 0) ? 0 : (v >= 0xffff) ? 0xffff : v;
+}
 #endif
 
-    // Interrupts freigeben
-#if defined(__AVR_ATmega32__)
-    TIMSK &= ~(1<<OCF2);
-#elif defined(__AVR_ATmega324P__) || defined(__AVR_ATmega644__) || defined(__AVR_ATmega644P__) || defined(__AVR_ATmega1284P__)
-    TIMSK2 &= ~(1<<OCIE2A);
+// value of U (SlotU != 0) or I, called by ADCStore
+static inline void StatStore(uint16_t Value, uint8_t SlotU)
+{
+#ifdef STATISTICS
+    uint32_t P;
+    uint16_t P16;
+
+    if (!SlotU)
+    {
+        StatI = StatValue(Value, StatOffsetI);
+        return;
+    }
+    if (StatSkip)
+    {
+        StatSkip--;
+        return;
+    }
+
+    Value = StatValue(Value, StatOffsetU);
+    P = (uint32_t)Value * StatI;
+    P16 = P >> 16;
+    StatAdd(&StatAcc.Ch[STAT_U], Value, (uint32_t)Value * Value);
+    StatAdd(&StatAcc.Ch[STAT_I], StatI, (uint32_t)StatI * StatI);
+    StatAdd(&StatAcc.Ch[STAT_P], P, (uint32_t)P16 * P16);
+
+    if (++StatAcc.Count == StatWindowISR)   // never with StatWindowISR = 0
+    {
+        StatDone = StatAcc;
+        StatStart();
+    }
 #else
-#error Please define your TIMER2 code
+    (void)Value;
+    (void)SlotU;
 #endif
-    sei();
+}
 
+// drops the statistics and starts with the window StatWindow, the offsets of the present ranges and
+// Skip values of U skipped (>= 1, the first one has no value of I yet)
+void Timer_StatRestart(int16_t OffsetU, int16_t OffsetI, uint8_t Skip)
+{
+#ifdef STATISTICS
+    uint8_t sreg = SREG;
+    cli();
+    StatWindowISR = StatWindow;
+    StatOffsetU = OffsetU;
+    StatOffsetI = OffsetI;
+    StatSkip = Skip ? Skip : 1;
+    StatDone.Count = 0;
+    StatStart();
+    SREG = sreg;
+#else
+    (void)OffsetU;
+    (void)OffsetI;
+    (void)Skip;
+#endif
+}
 
-    // check Ripple Mode, switch on/off synchronized with DACMux
+// copies the last complete window (the running one with StatWindow = 0), Restart != 0 starts the next
+// one at the same time. Returns 0 if there are no samples.
+uint8_t Timer_StatRead(STATS* pStats, uint8_t Restart)
+{
+#ifdef STATISTICS
+    uint8_t sreg = SREG;
+    cli();
+    *pStats = StatWindowISR ? StatDone : StatAcc;
+    if (Restart)
+    {
+        StatDone.Count = 0;
+        StatStart();
+    }
+    SREG = sreg;
+    return pStats->Count != 0;
+#else
+    pStats->Count = 0;
+    (void)Restart;
+    return 0;
+#endif
+}
 
-#ifdef DUAL_DAC
-    // for DUAL_DAC steps in 1ms are allowed
-    if (TimerState & 0x01)
+
+
+//*** Ticks of the waveform sources ***
+// All times of the waveform sources are in ms. The sources are called every tick, Step is the number
+// of ms completed with this tick: ARBSTEP in the Timer2 slots, 0 or 1 by the waveform tick below 1ms.
+// Between the ms the values are interpolated by the ticks within the ms, WAVETICKPRE.
+#ifdef WAVETICK
+static uint8_t  WaveTickISR = 1;    // WaveTicks as used by the interrupts, set by Timer_SelectHandlers
+static uint8_t  WaveShiftISR;       // log2(WaveTickISR)
+static uint8_t  WaveTickPre;        // ticks within the ms, counted by the waveform tick
+#define WAVETICKS   WaveTickISR
+#define WAVETICKPRE WaveTickPre
 #else
-    // for standard DCG hardware only steps in 2ms are allowed
-    if (TimerState == 3)
+#define WAVETICKS   1
+#define WAVETICKPRE 0
+#endif
+
+// value of the slope Inc (per ms, 16.16, two's complement for falling slopes) WAVETICKPRE ticks into the ms
+static inline uint32_t WaveInterp(uint32_t Acc, uint32_t Inc)
+{
+#ifdef WAVETICK
+    return Acc + WaveTickPre * (uint32_t)((int32_t)Inc >> WaveShiftISR);
+#else
+    (void)Inc;
+    return Acc;
 #endif
+}
+
+//*** Streaming Arbitrary Mode (ArbActive = 3) ***
+// Plays the segments of the ring buffer ArbStream, which is filled by ArbStreamPut in the main loop.
+// Called every tick of the arbitrary mode, Step in ms, see above. Returns the DAC value.
+static uint16_t ArbStreamTmr;       // time within the segment played
+static uint32_t ArbStreamAcc;       // interpolated DAC value in 16.16 fixed point
+
+static inline uint16_t ArbStreamTick(uint8_t Step)
+{
+    uint8_t Tail = ArbStream.Tail;
+
+    if (!ArbStream.Playing)
+    {
+        if ((Tail == ArbStream.Head) || WAVETICKPRE)    // nothing to play (yet), start with a ms
+        {
+            return ArbStream.Hold;
+        }
+        ArbStream.Playing = 1;
+        ArbStreamTmr = 0;
+        ArbStreamAcc = (uint32_t)ArbStream.DAC[Tail] << 16;
+    }
+
+    if (ArbStream.T[Tail] == 0)         // end of stream, hold the last point
+    {
+        ArbStream.Hold = ArbStream.DAC[Tail];
+        return ArbStream.Hold;
+    }
+
+    ArbStream.Hold = WaveInterp(ArbStreamAcc, ArbStream.Inc[Tail]) >> 16;
+    ArbStreamAcc += Step * ArbStream.Inc[Tail];
+    ArbStreamTmr += Step;
+
+    while (ArbStreamTmr >= ArbStream.T[Tail])   // at the end of the segment
     {
-        if ((RippleModeOn == 0) && (TmrRippleMod != 0) && (TmrRippleOn > 0) && (TmrRippleOff > 0))
+        ArbStreamTmr -= ArbStream.T[Tail];
+        Tail = (Tail + 1) & (ARBSTREAMSIZE - 1);
+        ArbStream.Tail = Tail;
+
+        if (Tail == ArbStream.Head)     // ring buffer ran empty before the end of the stream
+        {
+            ArbStream.Playing = 0;
+            ArbStreamUnderrun++;
+            break;
+        }
+        ArbStreamAcc = (uint32_t)ArbStream.DAC[Tail] << 16;
+        if (ArbStream.T[Tail] == 0)
         {
-            //init ripple mode and switch it on
-            RippleModeOn = 1;
-            RippleTicker = TmrRippleOn;
-            TimeRippleLow = 0;
+            break;
+        }
+        if (ArbStreamTmr)               // the remaining odd ms belongs to the new segment already
+        {
+            ArbStreamAcc += ArbStream.Inc[Tail];
         }
+    }
+
+    return ArbStream.Hold;
+}
+
+
+//*** Function generator (ArbActive = 4) ***
+// The phase accumulator runs through one period per 2^32, the upper 16 bits select the point of
+// the waveform. Sine and exponential shapes are interpolated from small tables with 65 points.
+static const PROGMEM uint16_t ArbFuncSinTable[65] =     // first quarter of a sine wave, 0..65535
+{
+        0,  1608,  3216,  4821,  6424,  8022,  9616, 11204,
+    12785, 14359, 15924, 17479, 19024, 20557, 22078, 23586,
+    25079, 26557, 28020, 29465, 30893, 32302, 33692, 35061,
+    36409, 37736, 39039, 40319, 41575, 42806, 44011, 45189,
+    46340, 47464, 48558, 49624, 50659, 51664, 52638, 53580,
+    54490, 55367, 56211, 57021, 57797, 58537, 59243, 59913,
+    60546, 61144, 61704, 62227, 62713, 63161, 63571, 63943,
+    64276, 64570, 64826, 65042, 65219, 65357, 65456, 65515,
+    65535
+};
+
+static const PROGMEM uint16_t ArbFuncExpTable[65] =     // (1 - e^(-5x)) / (1 - e^(-5)), 0..65535
+{
+        0,  4958,  9544, 13785, 17708, 21336, 24691, 27794,
+    30663, 33317, 35772, 38042, 40142, 42083, 43879, 45540,
+    47076, 48497, 49811, 51026, 52149, 53189, 54150, 55039,
+    55861, 56622, 57325, 57975, 58577, 59133, 59648, 60124,
+    60564, 60971, 61347, 61695, 62017, 62315, 62590, 62845,
+    63081, 63298, 63500, 63686, 63859, 64018, 64165, 64302,
+    64428, 64544, 64652, 64752, 64844, 64930, 65009, 65082,
+    65149, 65211, 65269, 65323, 65372, 65418, 65460, 65499,
+    65535
+};
+
+static uint32_t ArbFuncPhase;       // phase accumulator
+
+static uint16_t ArbFuncLookup(const uint16_t* Table, uint16_t x)   // x = 0..65535 over the table
+{
+    uint8_t i = x >> 10;
+    uint16_t a = pgm_read_word(&Table[i]);
+    uint16_t b = pgm_read_word(&Table[i + 1]);
+
+    return a + (((uint32_t)(b - a) * (x & 0x3ff)) >> 10);
+}
+
+static inline uint16_t ArbFuncTick(uint8_t Step)
+{
+    uint16_t Phase = WaveInterp(ArbFuncPhase, ArbFuncISR.PhaseInc) >> 16;
+    uint16_t y;
+
+    ArbFuncPhase += Step * ArbFuncISR.PhaseInc;
+
+    switch (ArbFuncISR.Shape)
+    {
+        default:
+        case ARBFUNC_SINE:
+            y = ArbFuncLookup(ArbFuncSinTable, (Phase & 0x4000) ? ~(Phase << 2) : (Phase << 2)) >> 1;
+            y = (Phase & 0x8000) ? 0x7fff - y : 0x8000 + y;
+            break;
+
+        case ARBFUNC_TRIANGLE:
+            if (Phase < ArbFuncISR.Duty)
+                y = (Phase * ArbFuncISR.RiseScale) >> 16;
+            else
+                y = 0xffff - (((Phase - ArbFuncISR.Duty) * ArbFuncISR.FallScale) >> 16);
+            break;
+
+        case ARBFUNC_SAWTOOTH:
+            y = Phase;
+            break;
+
+        case ARBFUNC_SQUARE:
+            y = (Phase < ArbFuncISR.Duty) ? 0xffff : 0;
+            break;
+
+        case ARBFUNC_EXP:
+            if (Phase < ArbFuncISR.Duty)
+                y = ArbFuncLookup(ArbFuncExpTable, (Phase * ArbFuncISR.RiseScale) >> 16);
+            else
+                y = 0xffff - ArbFuncLookup(ArbFuncExpTable, ((Phase - ArbFuncISR.Duty) * ArbFuncISR.FallScale) >> 16);
+            break;
+    }
+
+    return ArbFuncISR.DACLow + (((uint32_t)y * ArbFuncISR.DACSpan) >> 16);
+}
+
+
+//*** Program (ArbActive = 5) ***
+// Interprets the instructions of ArbPrg, the DAC values and reciprocal durations are taken from ArbPrgLinkPlay.
+// Instructions without duration are executed at once, up to ARBPRGMAX per tick (endless jumps).
+// Instructions start with a ms, so the segments and holds last their time from the start.
+static uint32_t ArbPrgAcc;          // level in 16.16 fixed point
+static uint32_t ArbPrgSlope;        // slope of the running segment, two's complement for falling slopes
+static uint16_t ArbPrgTmr;          // time within the running segment/hold
+static uint8_t  ArbPrgRunning;      // 1 = segment/hold ArbPrgPC is running
+static uint8_t  ArbPrgSP;           // loop stack pointer
+static uint8_t  ArbPrgLoopPC[ARBPRGLOOPS];
+static uint8_t  ArbPrgLoopCnt[ARBPRGLOOPS];
+static uint8_t  ArbPrgSetI;         // 1 = current limit set by the program
+static uint16_t ArbPrgDACI;         // current DAC value set by the program
+
+static inline uint16_t ArbPrgTick(uint8_t Step)
+{
+    uint8_t n;
+    uint16_t Diff, Level;
+    ARBINSTR* pInstr;
+    ARBINSTRLINK* pLink = ArbPrgLinkPlay;
+
+    if (ArbPrgRestart)
+    {
+        ArbPrgRestart = 0;
+        ArbPrgPC = ArbPrgSP = 0;
+        ArbPrgRunning = ArbPrgSetI = 0;
+        ArbPrgAcc = (uint32_t)ArbPrgStartDAC << 16;
+    }
+
+    for (n = 0; !ArbPrgRunning && !WAVETICKPRE && (n < ARBPRGMAX); n++)
+    {
+        if (ArbPrgPC >= ARBPRGMAX)
+        {
+            break;                                      // end of program memory, same as ARBOP_END
+        }
+        pInstr = &ArbPrg[ArbPrgPC];
+
+        switch (pInstr->Op)
+        {
+            case ARBOP_SEG:
+                if (pInstr->T == 0)                     // step
+                {
+                    ArbPrgAcc = (uint32_t)pLink[ArbPrgPC].DAC << 16;
+                    ArbPrgPC++;
+                    break;
+                }
+                Level = ArbPrgAcc >> 16;
+                Diff = (pLink[ArbPrgPC].DAC >= Level) ? pLink[ArbPrgPC].DAC - Level : Level - pLink[ArbPrgPC].DAC;
+                // Diff * 2^32 / T / 2^16 with two 16x16 multiplications
+                ArbPrgSlope = (uint32_t)Diff * (uint16_t)(pLink[ArbPrgPC].Recip >> 16)
+                            + (((uint32_t)Diff * (uint16_t)pLink[ArbPrgPC].Recip) >> 16);
+                if (pLink[ArbPrgPC].DAC < Level)
+                {
+                    ArbPrgSlope = -ArbPrgSlope;
+                }
+                ArbPrgTmr = 0;
+                ArbPrgRunning = 1;
+                break;
+
+            case ARBOP_HOLD:
+                if (pInstr->T == 0)
+                {
+                    ArbPrgPC++;
+                    break;
+                }
+                ArbPrgSlope = 0;
+                ArbPrgTmr = 0;
+                ArbPrgRunning = 1;
+                break;
+
+            case ARBOP_LOOP:
+                if (ArbPrgSP < ARBPRGLOOPS)             // deeper nesting is rejected by the parser, a jump out of a loop may get here
+                {
+                    ArbPrgLoopPC[ArbPrgSP] = ArbPrgPC + 1;
+                    ArbPrgLoopCnt[ArbPrgSP] = pInstr->Arg;
+                    ArbPrgSP++;
+                }
+                ArbPrgPC++;
+                break;
+
+            case ARBOP_NEXT:
+                if ((ArbPrgSP > 0) && ((ArbPrgLoopCnt[ArbPrgSP - 1] == 0) || (--ArbPrgLoopCnt[ArbPrgSP - 1] != 0)))
+                {
+                    ArbPrgPC = ArbPrgLoopPC[ArbPrgSP - 1];  // endless loop or repetitions left
+                }
+                else
+                {
+                    if (ArbPrgSP > 0)
+                    {
+                        ArbPrgSP--;
+                    }
+                    ArbPrgPC++;
+                }
+                break;
+
+            case ARBOP_JUMP:
+                ArbPrgPC = pInstr->Arg;
+                break;
+
+            case ARBOP_WAIT:
+                if (!ArbPrgTrigger)
+                {
+                    return ArbPrgAcc >> 16;             // try again with the next tick
+                }
+                ArbPrgTrigger = 0;
+                ArbPrgPC++;
+                break;
+
+            case ARBOP_SETI:
+                ArbPrgDACI = pLink[ArbPrgPC].DAC;
+                ArbPrgSetI = 1;
+                ArbPrgPC++;
+                break;
+
+            default:
+            case ARBOP_END:
+                return ArbPrgAcc >> 16;
+        }
+    }
+
+    Level = ArbPrgAcc >> 16;
+
+    if (ArbPrgRunning)
+    {
+        Level = WaveInterp(ArbPrgAcc, ArbPrgSlope) >> 16;
+        ArbPrgAcc += Step * ArbPrgSlope;
+        ArbPrgTmr += Step;
+
+        if (ArbPrgTmr >= ArbPrg[ArbPrgPC].T)            // end of segment/hold, continue exactly at the target
+        {
+            if (ArbPrg[ArbPrgPC].Op == ARBOP_SEG)
+            {
+                ArbPrgAcc = (uint32_t)pLink[ArbPrgPC].DAC << 16;
+            }
+            ArbPrgRunning = 0;
+            ArbPrgPC++;
+        }
+    }
+
+    return Level;
+}
+
+
+//*** Table (ArbActive = 1, 2) ***
+// The interpolation of the played bank, the current accumulator runs in lockstep with the voltage.
+typedef union
+{
+    uint32_t u32;
+    uint16_t u16[2];
+} Accu;
+
+// The table holds the slope per unit of the step (see CalcArbSlope). ArbAccUnit adds it once per completed
+// unit, so the error doesn't grow with the length of the unit. In between ArbAcc adds the slope per ms,
+// it is reloaded from ArbAccUnit at the end of every unit.
+static Accu ArbAcc;                 // interpolated DAC value in 16.16 fixed point, u16[1] is the DAC value
+static Accu ArbAccUnit;             // DAC value at the beginning of the running unit
+static uint32_t ArbIncMs;           // slope per ms of the running step, two's complement like Inc
+#ifdef ARBTABLE_I
+static Accu ArbAccI;                // the same for the current
+static Accu ArbAccUnitI;
+static uint32_t ArbIncMsI;
+static uint16_t ArbTableDACI;       // current DAC value of the voltage slot, output in the current slot
+#endif
+
+static uint16_t ArbPre;             // ms within the time unit of the running step, see ArbTimeTick
+
+// slope per unit into the slope per ms, the direction comes from the DAC values, the slope may exceed 2^31
+static inline uint32_t ArbSlopeMs(uint32_t Inc, uint16_t From, uint16_t To, uint8_t Unit)
+{
+    if ((Unit == ARBT_UNIT_MS) || (Inc == 0))
+    {
+        return Inc;
+    }
+    return (To >= From) ? Inc / ArbUnitMs[Unit] : -(-Inc / ArbUnitMs[Unit]);
+}
+
+// one division per step and not per tick. A step with a unit other than ms has a time > 0, so Index + 1 exists.
+static inline void ArbIncSet(ARBTABLE* pArb, uint8_t Index)
+{
+    ArbIncMs = ArbSlopeMs(pArb->Inc[Index], pArb->DAC[Index], pArb->DAC[Index + 1], pArb->Unit[Index]);
+#ifdef ARBTABLE_I
+    ArbIncMsI = ArbSlopeMs(pArb->IncI[Index], pArb->DACI[Index], pArb->DACI[Index + 1], pArb->Unit[Index]);
+#endif
+}
+
+// beginning of the step Index
+static inline void ArbAccSet(ARBTABLE* pArb, uint8_t Index)
+{
+    ArbPre = 0;
+    ArbIncSet(pArb, Index);
+    ArbAcc.u32 = ArbAccUnit.u32 = (uint32_t)pArb->DAC[Index] << 16;
+#ifdef ARBTABLE_I
+    ArbAccI.u32 = ArbAccUnitI.u32 = (uint32_t)pArb->DACI[Index] << 16;
+#endif
+}
+
+// continue at Tmr units (+ ArbPre ms) within the step Index of a new bank
+static inline void ArbAccSeek(ARBTABLE* pArb, uint8_t Index, uint16_t Tmr)
+{
+    if (ArbPre >= ArbUnitMs[pArb->Unit[Index]])
+    {
+        ArbPre = 0;
+    }
+    ArbIncSet(pArb, Index);
+
+    ArbAccUnit.u32 = ((uint32_t)pArb->DAC[Index] << 16) + Tmr * pArb->Inc[Index];
+    ArbAcc.u32 = ArbAccUnit.u32 + ArbPre * ArbIncMs;
+#ifdef ARBTABLE_I
+    ArbAccUnitI.u32 = ((uint32_t)pArb->DACI[Index] << 16) + Tmr * pArb->IncI[Index];
+    ArbAccI.u32 = ArbAccUnitI.u32 + ArbPre * ArbIncMsI;
+#endif
+}
+
+// increment of the step timer: Step for ms, else one per completed unit.
+// Constant time, the units are even, so Step 2 hits them exactly.
+static inline uint8_t ArbTimeTick(ARBTABLE* pArb, uint8_t Index, uint8_t Step)
+{
+    if (pArb->Unit[Index] == ARBT_UNIT_MS)
+    {
+        return Step;
+    }
+    ArbPre += Step;
+    if (ArbPre < ArbUnitMs[pArb->Unit[Index]])
+    {
+        return 0;
+    }
+    ArbPre -= ArbUnitMs[pArb->Unit[Index]];
+    return 1;
+}
+
+// advance the step Index by Step ms, returns the completed units for the step timer.
+// The units are even, so ArbPre is 0 when a unit is completed.
+static inline uint8_t ArbAccAdvance(ARBTABLE* pArb, uint8_t Index, uint8_t Step)
+{
+    uint8_t Units = ArbTimeTick(pArb, Index, Step);
+
+    if (Units)
+    {
+        ArbAccUnit.u32 += Units * pArb->Inc[Index];
+        ArbAcc.u32 = ArbAccUnit.u32;
+#ifdef ARBTABLE_I
+        ArbAccUnitI.u32 += Units * pArb->IncI[Index];
+        ArbAccI.u32 = ArbAccUnitI.u32;
+#endif
+    }
+    else
+    {
+        ArbAcc.u32 += Step * ArbIncMs;
+#ifdef ARBTABLE_I
+        ArbAccI.u32 += Step * ArbIncMsI;
+#endif
+    }
+    return Units;
+}
+
+// latch the current of the value which is output in this tick, the accumulator holds it before it is advanced
+static inline void ArbAccLatchI(ARBTABLE* pArb)
+{
+#ifdef ARBTABLE_I
+    ArbTableDACI = (pArb->Target == ARBTARGET_U) ? DACRawI : WaveInterp(ArbAccI.u32, ArbIncMsI) >> 16;
+#else
+    (void)pArb;
+#endif
+}
+
+static uint8_t  ArbIndex;           // step of the played bank
+static uint16_t ArbTmr;             // time within the step, in its unit
+static uint16_t ArbDlyTmr;          // delay after the sequence
+static uint16_t ArbTableOut;        // DAC value of the last tick
+
+// Called every tick of the arbitrary mode, Step in ms, see WaveInterp. Returns the DAC value.
+static uint16_t ArbTableTick(uint8_t Step)
+{
+    ARBTABLE* pArb = ArbTablePlay;  // table bank currently played
+
+    if (ArbTableNext && ArbSwapAtOnce)  // new table bank, continue at the same position
+    {
+        pArb = ArbTablePlay = ArbTableNext;
+        ArbTableNext = 0;
+        ArbAccSeek(pArb, ArbIndex, ArbTmr);
+    }
+
+    if (pArb == 0)                  // the only bank is filled by SetLevelDAC, hold the output
+    {
+        return ArbTableOut;
+    }
+
+    ArbAccLatchI(pArb);       // current for this tick, played in lockstep
+
+    if (( pArb->T[ArbIndex] == 0 ) || (ArbTrigger == 0x00))     // at the end of a complete sequence OR if repetitions are over
+    {
+        ArbTableOut = pArb->DAC[ArbIndex];
+        ArbTmr   = 0;
+        ArbIndex = 0;
+        if (ArbTableNext)                   // sequence boundary, switch to the new table bank
+        {
+            pArb = ArbTablePlay = ArbTableNext;
+            ArbTableNext = 0;
+        }
+        ArbAccSet(pArb, 0);
+        ArbDlyTmr = ArbDelayISR;
+        if ( (ArbTrigger != 0xff) && (ArbTrigger != 0x00) )
+        {
+            ArbTrigger--;
+        }
+    }
+    else if (ArbDlyTmr == 0)
+    {
+        if ( ArbTmr < pArb->T[ArbIndex] ) // to avoid ArbTmr out of range in case of change of sequence
+        {
+            ArbTableOut = WaveInterp(ArbAcc.u32, ArbIncMs) >> 16;  // no division here, the slope is precalculated by SetLevelDAC
+            ArbTmr += ArbAccAdvance(pArb, ArbIndex, Step);
+        }
+    }
+    else
+    {
+        ArbTableOut = pArb->DAC[ArbIndex];
+
+        if (ArbDlyTmr <= Step)      // just in case some uneven value made its way to this point
+        {
+            ArbDlyTmr = 0;
+        }
+        else
+        {
+            ArbDlyTmr -= Step;
+        }
+    }
+
+    while ( ArbTmr >= pArb->T[ArbIndex] )
+    {
+        ArbTmr -= pArb->T[ArbIndex];       // not set to zero to handle samples with uneven ms
+        ArbIndex++;
+
+        if ( pArb->T[ArbIndex] == 0 )
+        {
+            ArbIndex = 0;
+            if (ArbTableNext)                   // sequence boundary, switch to the new table bank
+            {
+                pArb = ArbTablePlay = ArbTableNext;
+                ArbTableNext = 0;
+            }
+            ArbTmr   = 0;           // at the end of a sequence, reset ArbTmr to "zero", even if it was "one". This can change the sequence by 1 ms (in case of standard hardware)
+            // This is to:
+            // - re-synchronize ArbTmr after switching of sequences (to avoid starting sequence with ArbTmr=1)
+            // - avoid toggling waveform between two sample sets (starting with alternating ArbTmr=0 or =1), if the total time of the sequence is odd ms.
+            ArbDlyTmr = ArbDelayISR;
+            CaptureEventSet(CAPTURE_EV_ARB);
+            if ( (ArbTrigger != 0xff) && (ArbTrigger != 0x00) )
+            {
+                ArbTrigger--;
+            }
+            ArbAccSet(pArb, 0);
+            break;                  // to avoid endless loop if the first sample is time accidentially zero
+        }
+
+        ArbAccSet(pArb, ArbIndex);
+        if (ArbTmr)                 // the remaining odd ms belongs to the new step already
+        {
+            ArbTmr = ArbAccAdvance(pArb, ArbIndex, ArbTmr);    // counted by the prescaler if the unit isn't ms
+        }
+    }
+
+    return ArbTableOut;
+}
+
+
+
+// Ripple Values (shared by the Timer2 interrupts)
+static uint8_t TimeRippleLow = 0;
+static uint8_t RippleModeOn = 0;
+static int16_t RippleTicker = 0;
+
+static uint8_t  RippleLowToHighU = 0;
+static uint8_t  RippleHighToLowU = 0;
+
+static uint8_t  RippleLowToHighI = 0;
+static uint8_t  RippleHighToLowI = 0;
+
+//*** ripple countdown, Step in ms ***
+static inline void RippleTick(uint8_t Step)
+{
+    if ((RippleModeOn == 0) && (TmrRippleMod != 0) && (TmrRippleOn > 0) && (TmrRippleOff > 0))
+    {
+        //init ripple mode and switch it on
+        RippleModeOn = 1;
+        RippleTicker = TmrRippleOn;
+        TimeRippleLow = 0;
+    }
+
+    if ((RippleModeOn == 1) && ((TmrRippleMod == 0) || (TmrRippleOn == 0) || (TmrRippleOff == 0) ))
+    {
+        // switch ripple mode off
+        RippleModeOn = 0;
+        RippleTicker = 0;
+        TimeRippleLow = 0;
+    }
+
+    if (RippleModeOn == 1)
+    {
+        // check current RippleTime, toggle OutputVoltage, if necessary
+        if (RippleTicker <= 0)      // if countdown is zero, toggle to...
+        {
+            CaptureEventSet(CAPTURE_EV_RIPPLE);
+            if (TimeRippleLow == 0)
+            {
+                TimeRippleLow = 1;  // ripple low output voltage
+                RippleTicker = TmrRippleOff;
+                RippleHighToLowU = 1;
+                RippleHighToLowI = 1;
+            }
+            else
+            {
+                TimeRippleLow = 0;  // default High output voltage
+                RippleTicker = TmrRippleOn;
+                RippleLowToHighU = 1;
+                RippleLowToHighI = 1;
+            }
+        }
+
+        RippleTicker -= Step;
+    }
+}
+
+//*** stores the averaged ADC value of the voltage (SlotU != 0) or current slot, switches the ADC MUX to the other one ***
+static inline void ADCStore(uint16_t Value, uint8_t SlotU)
+{
+    int16_t Ticker;
+
+#ifdef WAVETICK
+    uint8_t sreg = SREG;
+    cli();                      // counted down by the waveform tick, which may interrupt here
+    Ticker = RippleTicker;
+    SREG = sreg;
+#else
+    Ticker = RippleTicker;
+#endif
+
+    CaptureStore(Value, SlotU);
+    StatStore(Value, SlotU);
+
+    if (SlotU)
+    {
+        // 2, get voltage value every 2ms, (interlaced with current value 1ms later)
+
+#ifdef DUAL_DAC
+#define SETTLETIME 15 // 10     // in DUAL DAC mode settling time is faster... but the main reason is slow RC combination C11
+#else
+#define SETTLETIME 25 // 20
+#endif
+
+        // depending on the mode,
+        if ( // no ripple mode => always -or-
+            (RippleModeOn == 0) ||
+            // Arbitrary Mode on (is dominant over ripple mode)
+            (ArbActive != 0)  )
+        {
+            ADCRawU = ADCRawULow = Value;
+        }
+
+        if ((RippleModeOn == 1) && (ArbActive == 0))
+        {
+            // high level after settling time
+            if (( (TimeRippleLow == 0) && (((TmrRippleOn - Ticker) >= SETTLETIME) || (Ticker <= 1)) ) ||
+                    ((RippleLowToHighU == 1) && (TmrRippleOn < 3)) )
+            {
+//PORTD |= (1<<PD7);
+                ADCRawU = Value;
+                RippleLowToHighU = 0;
+//PORTD &= ~(1<<PD7);
+            }
+            // low level after settling time
+            else if  (( (TimeRippleLow == 1) && (((TmrRippleOff - Ticker) >= SETTLETIME) || (Ticker <= 1)) ) ||
+                      ((RippleHighToLowU == 1) && (TmrRippleOff < 3)) )
+            {
+//PORTD |= (1<<PD7);
+                ADCRawULow = Value;
+                RippleHighToLowU = 0;
+//PORTD &= ~(1<<PD7);
+            }
+        }
+    }
+    else
+    {
+        // 0, get current value
+
+        // depending on the mode,
+        if ( // no ripple mode => always -or-
+            (RippleModeOn == 0) ||
+            // Arbitrary Mode on (is dominant over ripple mode)
+            (ArbActive != 0)  )
+        {
+            ADCRawI = ADCRawILow = Value;
+        }
+
+        if ((RippleModeOn == 1) && (ArbActive == 0))
+        {
+            // high level after settling time
+            if (( (TimeRippleLow == 0) && (((TmrRippleOn - Ticker) >= SETTLETIME) || (Ticker <= 1)) ) ||
+                    ((RippleLowToHighI == 1) && (TmrRippleOn < 3)) )
+            {
+//PORTD |= (1<<PD7);
+                ADCRawI = Value;
+                RippleLowToHighI = 0;
+//PORTD &= ~(1<<PD7);
+            }
+            // low level after settling time
+            else if  (( (TimeRippleLow == 1) && (((TmrRippleOff - Ticker) >= SETTLETIME) || (Ticker <= 1)) ) ||
+                      ((RippleHighToLowI == 1) && (TmrRippleOff < 3)) )
+            {
+//PORTD |= (1<<PD7);
+                ADCRawILow = Value;
+                RippleHighToLowI = 0;
+//PORTD &= ~(1<<PD7);
+            }
+
+        }
+
+        //              ADCRawI = Value;
+    }
+}
+
+//*** switches the ADC MUX after the last sample of the voltage (SlotU != 0) or current ***
+static inline void ADCSwitchMux(uint8_t SlotU)
+{
+    if (SlotU)
+    {
+        PORTC &= ~(1<<PC6);     // MUX fr ADC auf I
+    }
+    else
+    {
+        PORTC |= (1<<PC6);      // MUX fr ADC auf U
+    }
+}
+
+//*** Pipelined acquisition of the LTC1864 ***
+// Each read returns the conversion started at the end of the read before, so no slot waits for a conversion.
+// A value of U (I) consists of ADCSamples samples:
+//      odd slot 1 (3):  the read at the beginning of the slot samples U (I)
+//      even slot 2 (0): ADCSamples - 1 reads, the first one right away, the others spaced by the conversion
+//                       time (compare B), the MUX switches to the other channel after the last one
+//      odd slot 3 (1):  the first read returns the last sample, the value is stored
+static uint32_t ADCSum;
+static uint8_t  ADCShift = 1;       // log2(ADCSamples) of the running value
+static uint8_t  ADCReads = 1;       // reads left in the even slot
+
+// the waveform tick loads the DACs by the same SCLK, a read must not be interrupted by it
+static inline uint16_t ADCShiftIn(void)
+{
+#ifdef WAVETICK
+    uint16_t Value;
+    uint8_t sreg = SREG;
+
+    cli();
+    Value = ShiftIn1864();
+    SREG = sreg;
+    return Value;
+#else
+    return ShiftIn1864();
+#endif
+}
+
+// odd slot: completes the value of the window before, the sample of this read belongs to the next one
+static inline void ADCReadOdd(uint8_t SlotU)
+{
+    ADCSum += ADCShiftIn();
+    ADCStore(ADCSum >> ADCShift, SlotU);
+
+    ADCSum = 0;
+    ADCShift = (ADCSamples >= 8) ? 3 : (ADCSamples >= 4) ? 2 : 1;
+    ADCReads = (1 << ADCShift) - 1;
+}
+
+// even slot: one read, returns 1 if there are more to do
+static inline uint8_t ADCReadEven(uint8_t SlotU)
+{
+    ADCSum += ADCShiftIn();
+    if (--ADCReads != 0)
+    {
+        return 1;
+    }
+    ADCSwitchMux(SlotU);
+    return 0;
+}
+
+//*** Skipped DAC updates, DACSkipped = count of the last second ***
+static uint16_t DACSkipCount;
+static uint16_t DACSkipWindow;
+
+static inline void DACSkip(uint8_t Count)
+{
+    DACSkipCount += Count;
+}
+
+// once per odd slot (1ms)
+static inline void DACSkipSecond(void)
+{
+    if (++DACSkipWindow >= 1000)
+    {
+        DACSkipped = DACSkipCount;
+        DACSkipCount = 0;
+        DACSkipWindow = 0;
+    }
+}
+
+#ifndef DUAL_DAC
+//*** Change tracking of the single DAC and the sample&hold of U and I ***
+// The S&H connected to the DAC is driven all the time, so a static value of it needs no update.
+// The other one droops from the moment it was disconnected, it gets a refresh in the SHRefresh-th
+// slot of its channel (hold time 2 * SHRefresh - 1 ms). A new value is output at once.
+// SHRefresh = 1 refreshes both S&H every 2ms like the former code.
+static uint16_t SHLast[2];          // last value of the S&H, [0] = I, [1] = U
+static uint8_t  SHAge[2] = {0xff, 0xff};    // slots of the channel since the S&H was disconnected
+static uint8_t  SHConnected = 0xff; // S&H connected to the DAC: 1 = U, 0 = I, 0xff = none
+
+// returns 1 if the DAC has to be loaded and switched to the S&H of the channel (SlotU != 0: U)
+static inline uint8_t SHUpdate(uint16_t Value, uint8_t SlotU)
+{
+    uint8_t Channel = SlotU ? 1 : 0;
+
+    if (Value == SHLast[Channel])
+    {
+        if (Channel == SHConnected)
+        {
+            return 0;
+        }
+        if (SHAge[Channel] + 1 < SHRefresh)
+        {
+            SHAge[Channel]++;
+            return 0;
+        }
+    }
+    SHLast[Channel] = Value;
+    SHAge[Channel] = 0;
+    SHConnected = Channel;
+    return 1;
+}
+#endif
+
+//*** Sub-states of a Timer2 slot, timed by OCR2B (not available on ATmega32) ***
+// The settle time of the DAC and the acquisition/conversion time of the LTC1864 were busy waits in
+// TIMER2_COMPA_vect (44us per ms). Now the compare unit B interrupts when a wait is over, the
+// main loop and the other interrupts run in between.
+#ifdef TIMER2_SUBSTATES
+
+#define T2SUB_IDLE          0
+#define T2SUB_DACSETTLED    1   // DAC settled, connect it to the sample&hold of U or I (single DAC only)
+#define T2SUB_ADCREAD       2   // conversion done, read it and start the next one
+
+#define T2SUB_DACSETTLE     25  // settle time of the DAC in us, formerly runtime of Encoder_MainFunction + 20us
+
+static uint8_t  T2SubState = T2SUB_IDLE;
+static uint8_t  T2SubSlotU;         // TimerState & 0x02 of the slot which started the sub-states
+
+// compare B interrupt after at least Counts timer ticks
+static inline void Timer2_SubSchedule(uint8_t Counts)
+{
+    uint16_t t = TCNT2 + Counts;
+
+    if (t > OCR2A)
+    {
+        t -= OCR2A + 1;             // CTC mode, the timer restarts after OCR2A
+    }
+    OCR2B = t;
+    TIFR2 = (1<<OCF2B);
+    TIMSK2 |= (1<<OCIE2B);
+}
+
+ISR(TIMER2_COMPB_vect)
+{
+    PROF_START(uint16_t, TCNT1);
+
+    switch (T2SubState)
+    {
+        case T2SUB_DACSETTLED:
+            if (T2SubSlotU)
+            {
+                PORTC |= (1<<PC4);          // MUXU fr DAC einschalten, 1=on
+            }
+            else
+            {
+                PORTC &= ~(1 << PC5);       // MPXI fr DAC einschalten, 0=on
+            }
+            T2SubState = T2SUB_IDLE;
+            break;
+
+        case T2SUB_ADCREAD:
+            if (ADCReadEven(T2SubSlotU))
+            {
+                Timer2_SubSchedule(T2SUB_COUNTS(4));
+                Timer_Profile(PROF_COMPB, (uint16_t)(TCNT1 - ProfStart));
+                return;
+            }
+            T2SubState = T2SUB_IDLE;
+            break;
+
+        default:
+            T2SubState = T2SUB_IDLE;
+            break;
+    }
+    TIMSK2 &= ~(1<<OCIE2B);
+    Timer_Profile(PROF_COMPB, (uint16_t)(TCNT1 - ProfStart));
+}
+#endif
+
+
+
+ISR(TIMER1_OVF_vect)
+{
+    Timer1Ovf++;
+}
+
+//*** Periods of the main loop jobs ***
+// A period which elapses again before its job has been started is an overrun, the job runs once only.
+static inline void Timer_Elapsed(uint8_t Job)
+{
+    if (TimerPending & (1<<Job))
+    {
+        if (SchedOverruns[Job] < INT16_MAX)
+        {
+            SchedOverruns[Job]++;
+        }
+    }
+    TimerPending |= (1<<Job);
+    TimerReady[Job] = (uint16_t)Timer2Slots * 5;
+}
+
+//*** Encoder, low priority ***
+// Encoder_MainFunction was called in every Timer2 slot and delayed the DAC settle and the ADC reads.
+// Timer0 calls it at the same rate in the middle of the slots, with the interrupts enabled. The Timer2
+// interrupt masks it until the slot is done, so the encoder never runs within a Timer2 slot.
+#if defined(__AVR_ATmega32__)
+#define TIMER0_IMSK     TIMSK
+#define TIMER0_IE       OCIE0
+#else
+#define TIMER0_IMSK     TIMSK0
+#define TIMER0_IE       OCIE0A
+#endif
+
+static volatile uint8_t EncoderRunning;
+
+#if defined(__AVR_ATmega32__)
+ISR(TIMER0_COMP_vect)
+#elif defined(__AVR_ATmega324P__) || defined(__AVR_ATmega644__) || defined(__AVR_ATmega644P__) || defined(__AVR_ATmega1284P__)
+ISR(TIMER0_COMPA_vect)
+#else
+#error Please define your TIMER0 code
+#endif
+{
+    PROF_START(uint16_t, TCNT1);
+
+    TIMER0_IMSK &= ~(1<<TIMER0_IE);
+    EncoderRunning = 1;
+    sei();
+
+    Encoder_MainFunction();
+
+    Timer_Profile(PROF_ENCODER, (uint16_t)(TCNT1 - ProfStart));
+    cli();
+    EncoderRunning = 0;
+    TIMER0_IMSK |= (1<<TIMER0_IE);
+}
+
+//*** Handlers of the Timer2 slots, selected by Timer_SelectHandlers ***
+// The ISR calls the fitted DAC and ADC driver and the waveform source of the mode without checking
+// the options and ArbActive on every pass.
+#if defined(DUAL_DAC) && !defined(DEBUGSTDHW)
+#define ARBSTEP     1               // tick of the arbitrary modes in ms
+#else
+#define ARBSTEP     2               // standard hardware outputs U every 2nd ms
+#endif
+
+// static voltage, ripple mode
+static uint16_t WaveStaticU(uint8_t Step __attribute__((unused)))
+{
+    if ((RippleModeOn == 1) && (TimeRippleLow == 1))
+    {
+        return DACRawURipple;
+    }
+    return DACRawU;
+}
+
+static uint16_t WaveStaticI(void)
+{
+    return DACRawI;
+}
+
+// the program may override the static current
+static uint16_t WavePrgI(void)
+{
+    return ArbPrgSetI ? ArbPrgDACI : DACRawI;
+}
+
+#ifdef ARBTABLE_I
+static uint16_t WaveTableI(void)
+{
+    return ArbTableDACI;
+}
+#endif
+
+#ifdef DEBUGSTDHW
+// for debugging standard hardware on Dual-DAC hardware: the arbitrary modes every 2nd ms
+static uint16_t (*WaveArbU)(uint8_t Step);
+static uint8_t  ArbToggle;
+static uint16_t ArbToggleOut;
+
+static uint16_t WaveStdHwU(uint8_t Step)
+{
+    ArbToggle ^= 1;
+    if (ArbToggle)
+    {
+        ArbToggleOut = WaveArbU(Step);
+    }
+    return ArbToggleOut;
+}
+#endif
+
+static void ADCNone(uint8_t SlotU __attribute__((unused)))
+{
+}
+
+static void ADCStartEven(uint8_t SlotU)
+{
+    // the first read needs no wait, its conversion has been started by the odd slot
+#ifdef TIMER2_SUBSTATES
+    if (ADCReadEven(SlotU))
+    {
+        T2SubSlotU = SlotU;
+        T2SubState = T2SUB_ADCREAD;         // the other reads by TIMER2_COMPB_vect
+        Timer2_SubSchedule(T2SUB_COUNTS(4));
+    }
+#else
+    while (ADCReadEven(SlotU))
+    {
+        _delay_us(4);                       // conversion time
+    }
+#endif
+}
+
+#ifdef DUAL_DAC
+static void ShiftOut1257Dual(uint16_t Value, uint8_t Channel __attribute__((unused)))
+{
+    ShiftOut1257(Value);
+}
+
+static void (*DACDriver)(uint16_t Value, uint8_t Channel) = ShiftOut1257Dual;
+#else
+static void (*DACDriver)(uint16_t Value) = ShiftOut1257;
+#endif
+static void (*ADCDriverOdd)(uint8_t SlotU) = ADCNone;
+static void (*ADCDriverEven)(uint8_t SlotU) = ADCNone;
+static uint16_t (*WaveSourceU)(uint8_t Step) = WaveStaticU;
+static uint16_t (*WaveSourceI)(void) = WaveStaticI;
+
+#ifdef DUAL_DAC
+static uint16_t lastUDACOut = 0xffff;
+static uint16_t lastIDACOut = 0xffff;
+
+// loads the DACs whose value changed, in the odd Timer2 slots or by the waveform tick
+static inline void DACLoad(uint16_t U, uint16_t I)
+{
+    DACSkip((lastUDACOut == U) + (lastIDACOut == I));
+    if (lastUDACOut != U)
+    {
+        lastUDACOut = U;
+        DACLastOut = U;
+
+        DACDriver(U, 0);     //Lade den Spannungs-DAC
+    }
+    if (lastIDACOut != I)
+    {
+        lastIDACOut = I;
+
+        DACDriver(I, 1);     //Lade den Strom-DAC
+    }
+}
+#endif
+
+#ifdef WAVETICK
+#if defined(__AVR_ATmega32__)
+#define TIMER1_IMSK     TIMSK
+#define TIMER1_IFR      TIFR
+#else
+#define TIMER1_IMSK     TIMSK1
+#define TIMER1_IFR      TIFR1
+#endif
+
+static uint16_t WaveTickCycles;     // period of the waveform tick in Timer1 cycles
+static uint8_t  WaveRunU;           // 1 = no range switch of U running, the tick plays the waveform
+static uint8_t  WaveRunI;
+#endif
+
+// called by InitScales (options) and SetLevelDAC (ArbActive)
+void Timer_SelectHandlers(void)
+{
+    uint16_t (*WaveU)(uint8_t Step);
+    uint16_t (*WaveI)(void) = WaveStaticI;
+    uint8_t sreg;
+
+    switch (ArbActive)
+    {
+        case 1:
+        case 2:
+            WaveU = ArbTableTick;
+#ifdef ARBTABLE_I
+            WaveI = WaveTableI;
+#endif
+            break;
+
+        case 3:
+            WaveU = ArbStreamTick;
+            break;
+
+        case 4:
+            WaveU = ArbFuncTick;
+            break;
+
+        case 5:
+            WaveU = ArbPrgTick;
+            WaveI = WavePrgI;
+            break;
+
+        default:
+            WaveU = WaveStaticU;
+            break;
+    }
+
+    sreg = SREG;
+    cli();
+
+#ifdef DEBUGSTDHW
+    WaveArbU = WaveU;
+    WaveSourceU = (WaveU == WaveStaticU) ? WaveStaticU : WaveStdHwU;
+#else
+    WaveSourceU = WaveU;
+#endif
+    WaveSourceI = WaveI;
+
+#ifdef DUAL_DAC
+    DACDriver = Params.Options.DAC16Present ? ShiftOut1655 : ShiftOut1257Dual;
+#else
+    DACDriver = Params.Options.DAC16Present ? ShiftOut1655 : ShiftOut1257;
+#endif
+    ADCDriverOdd = Params.Options.ADC16Present ? ADCReadOdd : ADCNone;
+    ADCDriverEven = Params.Options.ADC16Present ? ADCStartEven : ADCNone;
+
+#ifdef WAVETICK
+    // the waveform tick takes over the output of the Timer2 slots
+    if (WaveTicks > 1)
+    {
+        WaveTickCycles = F_CPU / 1000 / WaveTicks;
+        if (!(TIMER1_IMSK & (1<<OCIE1A)))
+        {
+            OCR1A = TCNT1 + WaveTickCycles;
+            TIMER1_IFR = (1<<OCF1A);
+            TIMER1_IMSK |= (1<<OCIE1A);
+        }
+    }
+    else
+    {
+        TIMER1_IMSK &= ~(1<<OCIE1A);
+    }
+    if (WaveTickISR != WaveTicks)   // the ms in progress is lost only when the tick changes
+    {
+        WaveTickPre = 0;
+        WaveTickISR = WaveTicks;
+        WaveShiftISR = (WaveTicks >= 8) ? 3 : (WaveTicks >= 4) ? 2 : (WaveTicks >= 2) ? 1 : 0;
+    }
+#endif
+
+    SREG = sreg;
+}
+
+
+#ifdef WAVETICK
+//*** Waveform tick, WaveTicks per ms by compare A of the free running Timer1 ***
+// Plays the waveform source of the mode in steps below 1ms, decoupled from the Timer2 slots, which keep
+// switching the ranges and reading the ADC. The times stay in ms, the last tick of a ms completes it and
+// counts the ripple. It doesn't nest, the ADC reads are protected against it as they share SCLK with the DACs.
+ISR(TIMER1_COMPA_vect)
+{
+    PROF_START(uint16_t, TCNT1);
+    uint16_t U = 0;
+    uint16_t I = 0;
+    uint8_t Step = (WaveTickPre + 1 >= WaveTickISR);   // 1 = the ms is completed with this tick
+
+    OCR1A += WaveTickCycles;
+
+    if (Step)
+    {
+        RippleTick(1);
+    }
+    if (WaveRunU)
+    {
+        U = WaveSourceU(Step);
+        if (Params.OutputOnOff == 0)
+            U = 0;
+    }
+    if (WaveRunI)
+    {
+        I = WaveSourceI();
+    }
+    DACLoad(U, I);
+    WaveTickPre = Step ? 0 : WaveTickPre + 1;
+
+    Timer_Profile(PROF_WAVETICK, (uint16_t)(TCNT1 - ProfStart));
+}
+#endif
+
+
+#if defined(__AVR_ATmega32__)
+ISR(TIMER2_COMP_vect)
+#elif defined(__AVR_ATmega324P__) || defined(__AVR_ATmega644__) || defined(__AVR_ATmega644P__) || defined(__AVR_ATmega1284P__)
+ISR(TIMER2_COMPA_vect)
+#else
+#error Please define your TIMER2 code
+#endif
+{
+    static uint8_t lastRangeU = 0xff;
+    static uint8_t stateRangeU = 0xff;
+    static uint8_t lastRangeI = 0xff;
+    static uint8_t stateRangeI = 0xff;
+
+#ifndef DUAL_DAC
+    typedef union
+    {
+        uint32_t u32;
+        uint16_t u16;
+    } Values;
+#endif
+
+#ifdef DUAL_DAC
+    typedef struct
+    {
+        uint16_t U;
+        uint16_t I;
+    } DACData;
+
+    static DACData DACOut =
+    {
+        .U = 0,
+        .I = 0,
+    };
+#endif
+
+#ifndef DUAL_DAC
+    static Values Value;
+    uint8_t Refresh;                    // DAC loaded in this slot, S&H to switch
+#endif
+
+    PROF_START(uint16_t, TCNT1);
+
+    Timer2Slots++;                  // before sei, Timer_GetTicker relies on the pending flag until here
+    TIMER0_IMSK &= ~(1<<TIMER0_IE); // no encoder within the slot
+
+    // Interrupts freigeben
+#if defined(__AVR_ATmega32__)
+    TIMSK &= ~(1<<OCF2);
+#elif defined(__AVR_ATmega324P__) || defined(__AVR_ATmega644__) || defined(__AVR_ATmega644P__) || defined(__AVR_ATmega1284P__)
+    TIMSK2 &= ~(1<<OCIE2A);
+#else
+#error Please define your TIMER2 code
+#endif
+    sei();
 
-        if ((RippleModeOn == 1) && ((TmrRippleMod == 0) || (TmrRippleOn == 0) || (TmrRippleOff == 0) ))
-        {
-            // switch ripple mode off
-            RippleModeOn = 0;
-            RippleTicker = 0;
-            TimeRippleLow = 0;
-        }
+    // the sample of the odd slot is taken before the DAC changes, the one of the even slot before completes the value
+    if (TimerState & 0x01)
+    {
+        ADCDriverOdd(TimerState & 0x02);
+    }
 
-        if (RippleModeOn == 1)
-        {
-            // check current RippleTime, toggle OutputVoltage, if necessary
-            if (RippleTicker <= 0)      // if countdown is zero, toggle to...
-            {
-                if (TimeRippleLow == 0)
-                {
-                    TimeRippleLow = 1;  // ripple low output voltage
-                    RippleTicker = TmrRippleOff;
-                    RippleHighToLowU = 1;
-                    RippleHighToLowI = 1;
-                }
-                else
-                {
-                    TimeRippleLow = 0;  // default High output voltage
-                    RippleTicker = TmrRippleOn;
-                    RippleLowToHighU = 1;
-                    RippleLowToHighI = 1;
-                }
-            }
+    // check Ripple Mode, switch on/off synchronized with DACMux
 
 #ifdef DUAL_DAC
-            // for DUAL_DAC steps in 1ms are allowed
-            RippleTicker--;
+    // for DUAL_DAC steps in 1ms are allowed, a faster waveform tick counts them itself
+#ifdef WAVETICK
+    if ((TimerState & 0x01) && (WaveTickISR == 1))
 #else
-            // for standard DCG hardware only steps in 2ms are allowed
-            RippleTicker -= 2;
+    if (TimerState & 0x01)
 #endif
-        }
+    {
+        RippleTick(1);
+    }
+#else
+    // for standard DCG hardware only steps in 2ms are allowed
+    if (TimerState == 3)
+    {
+        RippleTick(2);
     }
+#endif
 
 
     if (TimerState & 0x01)
     {
 #ifndef DUAL_DAC
-
-        // MUX fr DAC abschalten
-        PORTC &= ~(1<<PC4);     // MPXU abschalten, 0=off
-        PORTC |= (1<<PC5);      // MPXI abschalten, 1=off
-
-
         if (TimerState & 0x02)
         {
 #endif
@@ -280,225 +1850,24 @@ ISR(TIMER2_COMPA_vect)
                 stateRangeU = 0;
                 lastRangeU = RangeU;
             }
+#ifdef WAVETICK
+            WaveRunU = (stateRangeU > 3);
+#endif
             switch (stateRangeU)
             {
                 default:
+#ifdef WAVETICK
+                    if (WaveTickISR > 1)
+                        break;          // output by the waveform tick
+#endif
 #ifdef DUAL_DAC
-                    if ( ArbActive == 0 )
-                    {
-                        if ((RippleModeOn == 1) && (TimeRippleLow == 1))
-                        {
-                            DACOut.U = DACRawURipple;
-                        }
-                        else
-                        {
-                            DACOut.U = DACRawU;
-                        }
-                    }
-                    else
-//*** Code for Arbitrary Mode for DualDAC mode ****************************************************
-#ifndef DEBUGSTDHW
-// normal code for DualDAC
-                    {
-                        if ( (ArbT[ArbIndex] == 0 ) || (ArbTrigger == 0x00))        // at the end of a complete sequence OR if repetitions are over
-                        {
-                            DACOut.U = ArbDAC[ArbIndex];
-                            ArbTmr   = 0;
-                            ArbIndex = 0;
-                            ArbDlyTmr = ArbDelayISR;
-                            if ( (ArbTrigger != 0xff) && (ArbTrigger != 0x00) )
-                            {
-                                ArbTrigger--;
-                            }
-                        }
-                        else if (ArbDlyTmr == 0)
-                        {
-                            if ( ArbTmr < ArbT[ArbIndex] ) // to avoid ArbTmr out of range in case of change of sequence
-
-                            {
-                                DACOut.U = (int32_t)ArbDAC[ArbIndex] + ((int32_t)ArbDAC[ArbIndex+1] - (int32_t)ArbDAC[ArbIndex]) * (int32_t)ArbTmr / (int32_t)ArbT[ArbIndex];
-                                ArbTmr++;
-                            }
-                        }
-                        else
-                        {
-                            DACOut.U = ArbDAC[ArbIndex];
-                            ArbDlyTmr--;
-                        }
-
-                        if ( ArbTmr >= ArbT[ArbIndex] )                             // at the end of the time between two steps
-                        {
-                            ArbTmr   = 0;
-                            ArbIndex++;
-
-                            if ( ArbT[ArbIndex] == 0 )
-                            {
-                                ArbIndex = 0;
-                                ArbDlyTmr = ArbDelayISR;
-                                if ( (ArbTrigger != 0xff) && (ArbTrigger != 0x00) )
-                                {
-                                    ArbTrigger--;
-                                }
-                            }
-                        }
-                    }
-
-//****************************
-#else // !DEBUGSTDHW
-                    {
-                        if (ArbToggle == 1)
-                        {
-                            ArbToggle = 0;
-                        }
-                        else
-                        {
-                            ArbToggle =1;
-
-//****************************
-//begin of copy from standard routine
-//replace Value.u16 by DACOut.U
-                            {
-                                if (( ArbT[ArbIndex] == 0 ) || (ArbTrigger == 0x00))
-                                {
-                                    DACOut.U = ArbDAC[ArbIndex];
-                                    ArbTmr   = 0;
-                                    ArbIndex = 0;
-                                    ArbDlyTmr = ArbDelayISR;
-                                    if ( (ArbTrigger != 0xff) && (ArbTrigger != 0x00) )
-                                    {
-                                        ArbTrigger--;
-                                    }
-                                }
-                                else if (ArbDlyTmr == 0)
-                                {
-                                    if ( ArbTmr < ArbT[ArbIndex] ) // to avoid ArbTmr out of range in case of change of sequence
-                                    {
-                                        DACOut.U = (int32_t)ArbDAC[ArbIndex] + ((int32_t)ArbDAC[ArbIndex+1] - (int32_t)ArbDAC[ArbIndex]) * (int32_t)ArbTmr / (int32_t)ArbT[ArbIndex];
-                                        ArbTmr+=2;      // timer increment is 2 for standard hardware
-                                    }
-                                }
-                                else
-                                {
-                                    DACOut.U = ArbDAC[ArbIndex];
-
-                                    if (ArbDlyTmr == 1) // just in case some uneven value made its way to this point
-                                    {
-                                        ArbDlyTmr = 0;
-                                    }
-                                    else
-                                    {
-                                        ArbDlyTmr-=2;
-                                    }
-                                }
-
-
-                                while ( ArbTmr >= ArbT[ArbIndex] )
-                                {
-                                    ArbTmr -= ArbT[ArbIndex];       // not set to zero to handle samples with uneven ms
-                                    ArbIndex++;
-
-                                    if ( ArbT[ArbIndex] == 0 )
-                                    {
-                                        ArbIndex = 0;
-                                        ArbTmr   = 0;           // at the end of a sequence, reset ArbTmr to "zero", even if it was "one". This can change the sequence by 1 ms (in case of standard hardware)
-                                        // This is to:
-                                        // - re-synchronize ArbTmr after switching of sequences (to avoid starting sequence with ArbTmr=1)
-                                        // - avoid toggling waveform between two sample sets (starting with alternating ArbTmr=0 or =1), if the total time of the sequence is odd ms.
-                                        ArbDlyTmr = ArbDelayISR;
-                                        if ( (ArbTrigger != 0xff) && (ArbTrigger != 0x00) )
-                                        {
-                                            ArbTrigger--;
-                                        }
-                                        break;                  // to avoid endless loop if the first sample is time accidentially zero
-                                    }
-                                }
-
-
-                            }
-//end of copy from standard routine
-//****************************
-                        }
-                    }
-#endif // DEBUGSTDHW
+                    DACOut.U = WaveSourceU(ARBSTEP);
                     if (Params.OutputOnOff == 0)
                         DACOut.U = 0;
-
-//*** Code for Arbitrary Mode for single lDAC mode  *************************************************
 #else
-                    if ( ArbActive == 0 )
-                    {
-                        if ((RippleModeOn == 1) && (TimeRippleLow == 1))
-                        {
-                            Value.u16 = DACRawURipple;
-                        }
-                        else
-                        {
-                            Value.u16 = DACRawU;
-                        }
-                    }
-                    else
-//*** Code for Arbitrary Mode for standard DAC mode *************************************************
-                    {
-                        if (( ArbT[ArbIndex] == 0 ) || (ArbTrigger == 0x00))
-                        {
-                            Value.u16 = ArbDAC[ArbIndex];
-                            ArbTmr   = 0;
-                            ArbIndex = 0;
-                            ArbDlyTmr = ArbDelayISR;
-                            if ( (ArbTrigger != 0xff) && (ArbTrigger != 0x00) )
-                            {
-                                ArbTrigger--;
-                            }
-                        }
-                        else if (ArbDlyTmr == 0)
-                        {
-                            if ( ArbTmr < ArbT[ArbIndex] ) // to avoid ArbTmr out of range in case of change of sequence
-                            {
-                                Value.u16 = (int32_t)ArbDAC[ArbIndex] + ((int32_t)ArbDAC[ArbIndex+1] - (int32_t)ArbDAC[ArbIndex]) * (int32_t)ArbTmr / (int32_t)ArbT[ArbIndex];
-                                ArbTmr+=2;      // timer increment is 2 for standard hardware
-                            }
-                        }
-                        else
-                        {
-                            Value.u16 = ArbDAC[ArbIndex];
-
-                            if (ArbDlyTmr == 1) // just in case some uneven value made its way to this point
-                            {
-                                ArbDlyTmr = 0;
-                            }
-                            else
-                            {
-                                ArbDlyTmr-=2;
-                            }
-                        }
-
-
-                        while ( ArbTmr >= ArbT[ArbIndex] )
-                        {
-                            ArbTmr -= ArbT[ArbIndex];       // not set to zero to handle samples with uneven ms
-                            ArbIndex++;
-
-                            if ( ArbT[ArbIndex] == 0 )
-                            {
-                                ArbIndex = 0;
-                                ArbTmr   = 0;           // at the end of a sequence, reset ArbTmr to "zero", even if it was "one". This can change the sequence by 1 ms (in case of standard hardware)
-                                // This is to:
-                                // - re-synchronize ArbTmr after switching of sequences (to avoid starting sequence with ArbTmr=1)
-                                // - avoid toggling waveform between two sample sets (starting with alternating ArbTmr=0 or =1), if the total time of the sequence is odd ms.
-                                ArbDlyTmr = ArbDelayISR;
-                                if ( (ArbTrigger != 0xff) && (ArbTrigger != 0x00) )
-                                {
-                                    ArbTrigger--;
-                                }
-                                break;                  // to avoid endless loop if the first sample is time accidentially zero
-                            }
-                        }
-                    }
-
+                    Value.u16 = WaveSourceU(ARBSTEP);
                     if (Params.OutputOnOff == 0)
                         Value.u16 = 0;
-
-//*** ******************************************** *************************************************
 #endif
                     break;
 
@@ -545,13 +1914,20 @@ ISR(TIMER2_COMPA_vect)
                 stateRangeI = 0;
                 lastRangeI = RangeI;
             }
+#ifdef WAVETICK
+            WaveRunI = (stateRangeI > 3);
+#endif
             switch (stateRangeI)
             {
                 default:
+#ifdef WAVETICK
+                    if (WaveTickISR > 1)
+                        break;
+#endif
 #ifdef DUAL_DAC
-                    DACOut.I = DACRawI;
+                    DACOut.I = WaveSourceI();
 #else
-                    Value.u16 = DACRawI;
+                    Value.u16 = WaveSourceI();
 #endif
                     break;
 
@@ -585,190 +1961,88 @@ ISR(TIMER2_COMPA_vect)
 //*** Loading DACs *************************************************
 
 #ifdef DUAL_DAC
-        if (lastUDACOut != DACOut.U)
-        {
-            lastUDACOut = DACOut.U;
-
-            if (Params.Options.DAC16Present)
-            {
-                ShiftOut1655(DACOut.U, 0); //Lade den Spannungs-DAC
-            }
-            else
-            {
-                ShiftOut1257(DACOut.U);
-            }
-        }
-        if (lastIDACOut != DACOut.I)
+#ifdef WAVETICK
+        if (WaveTickISR == 1)
+#endif
         {
-            lastIDACOut = DACOut.I;
-
-            if (Params.Options.DAC16Present)
-            {
-                ShiftOut1655(DACOut.I, 1); //Lade den Strom-DAC
-            }
-            else
-            {
-                ShiftOut1257(DACOut.I);
-            }
+            DACLoad(DACOut.U, DACOut.I);
         }
 
 #else
 
-        if (Params.Options.DAC16Present)
+        Refresh = SHUpdate(Value.u16, TimerState & 0x02);
+        if (Refresh)
         {
-            ShiftOut1655(Value.u16);
+            // MUX fr DAC abschalten
+            PORTC &= ~(1<<PC4);     // MPXU abschalten, 0=off
+            PORTC |= (1<<PC5);      // MPXI abschalten, 1=off
+
+            DACLastOut = Value.u16;
+            DACDriver(Value.u16);
         }
         else
         {
-            ShiftOut1257(Value.u16);
+            DACSkip(1);
         }
 #endif
+        DACSkipSecond();
 
         // Periodische Timer aktualisieren
-        if (TimerFlags.TimersActive)
+        if (TimersActive)
         {
             if (++TimeBase4ms >= TIMER_4MS)
             {
-                TimerFlags.Timer4msOV = 1;
+                Timer_Elapsed(TIMER_JOB_4MS);
                 TimeBase4ms = 0;
             }
             if (++TimeBase10ms >= TIMER_10MS)
             {
-                TimerFlags.Timer10msOV = 1;
+                Timer_Elapsed(TIMER_JOB_10MS);
                 TimeBase10ms = 0;
             }
             if (++TimeBase100ms >= TIMER_100MS)
             {
-                TimerFlags.Timer100msOV = 1;
+                Timer_Elapsed(TIMER_JOB_100MS);
                 TimeBase100ms = 0;
             }
             if (TimeBase100ms == 0 ||
                     TimeBase100ms == TIMER_50MS)
             {
-                TimerFlags.Timer50msOV = 1;
+                Timer_Elapsed(TIMER_JOB_50MS);
             }
         }
-        Encoder_MainFunction();                   // runtime is part of the DAC settle time
-        _delay_us(20);                  // more settle time
-
 #ifndef DUAL_DAC
-        if (TimerState & 0x02)
+#ifdef TIMER2_SUBSTATES
+        if (Refresh)
         {
-            // 3
-            PORTC |= (1<<PC4);          // MUXU fr DAC einschalten, 1=on
+            T2SubSlotU = TimerState & 0x02;
+            T2SubState = T2SUB_DACSETTLED;  // the MUX is switched by TIMER2_COMPB_vect
+            Timer2_SubSchedule(T2SUB_COUNTS(T2SUB_DACSETTLE));
         }
-        else
+#else
+        if (Refresh)
         {
-            // 1
-            PORTC &= ~(1 << PC5);       // MPXI fr DAC einschalten, 0=on
-        }
-#endif
-
-    }
-    else
-    {
-        // AD Wandlung
-        if (Params.Options.ADC16Present)
-        {
-            PORTB |= (1<<PB0);          // SCLK high
-            _delay_us(1);
-            PORTB &= ~(1<<PB7);         // STRADC low
-            Value.u32 = 0;
-            _delay_us(4);
-            PORTB |= (1<<PB7);          // STRADC high, Wandlung wird gestartet
-            ShiftIn1864();
-            for (i = 0; i < 4; i++)
-            {
-                Value.u32 += ShiftIn1864();
-            }
-            Value.u32 /= 4;
+            _delay_us(25);                  // settle time, formerly runtime of Encoder_MainFunction + 20us
 
             if (TimerState & 0x02)
             {
-                // 2, get voltage value every 2ms, (interlaced with current value 1ms later)
-
-#ifdef DUAL_DAC
-#define SETTLETIME 15 // 10     // in DUAL DAC mode settling time is faster... but the main reason is slow RC combination C11
-#else
-#define SETTLETIME 25 // 20
-#endif
-
-                // depending on the mode,
-                if ( // no ripple mode => always -or-
-                    (RippleModeOn == 0) ||
-                    // Arbitrary Mode on (is dominant over ripple mode)
-                    (ArbActive == 1)  )
-                {
-                    ADCRawU = ADCRawULow = Value.u16;
-                }
-
-                if ((RippleModeOn == 1) && (ArbActive == 0))
-                {
-                    // high level after settling time
-                    if (( (TimeRippleLow == 0) && (((TmrRippleOn - RippleTicker) >= SETTLETIME) || (RippleTicker <= 1)) ) ||
-                            ((RippleLowToHighU == 1) && (TmrRippleOn < 3)) )
-                    {
-//PORTD |= (1<<PD7);
-                        ADCRawU = Value.u16;
-                        RippleLowToHighU = 0;
-//PORTD &= ~(1<<PD7);
-                    }
-                    // low level after settling time
-                    else if  (( (TimeRippleLow == 1) && (((TmrRippleOff - RippleTicker) >= SETTLETIME) || (RippleTicker <= 1)) ) ||
-                              ((RippleHighToLowU == 1) && (TmrRippleOff < 3)) )
-                    {
-//PORTD |= (1<<PD7);
-                        ADCRawULow = Value.u16;
-                        RippleHighToLowU = 0;
-//PORTD &= ~(1<<PD7);
-                    }
-                }
-
-                PORTC &= ~(1<<PC6);     // MUX fr ADC auf I
+                // 3
+                PORTC |= (1<<PC4);          // MUXU fr DAC einschalten, 1=on
             }
             else
             {
-                // 0, get current value
-
-                // depending on the mode,
-                if ( // no ripple mode => always -or-
-                    (RippleModeOn == 0) ||
-                    // Arbitrary Mode on (is dominant over ripple mode)
-                    (ArbActive == 1)  )
-                {
-                    ADCRawI = ADCRawILow = Value.u16;
-                }
-
-                if ((RippleModeOn == 1) && (ArbActive == 0))
-                {
-                    // high level after settling time
-                    if (( (TimeRippleLow == 0) && (((TmrRippleOn - RippleTicker) >= SETTLETIME) || (RippleTicker <= 1)) ) ||
-                            ((RippleLowToHighI == 1) && (TmrRippleOn < 3)) )
-                    {
-//PORTD |= (1<<PD7);
-                        ADCRawI = Value.u16;
-                        RippleLowToHighI = 0;
-//PORTD &= ~(1<<PD7);
-                    }
-                    // low level after settling time
-                    else if  (( (TimeRippleLow == 1) && (((TmrRippleOff - RippleTicker) >= SETTLETIME) || (RippleTicker <= 1)) ) ||
-                              ((RippleHighToLowI == 1) && (TmrRippleOff < 3)) )
-                    {
-//PORTD |= (1<<PD7);
-                        ADCRawILow = Value.u16;
-                        RippleHighToLowI = 0;
-//PORTD &= ~(1<<PD7);
-                    }
-
-                }
-
-                //              ADCRawI = Value.u16;
-
-
-                PORTC |= (1<<PC6);      // MUX fr ADC auf U
+                // 1
+                PORTC &= ~(1 << PC5);       // MPXI fr DAC einschalten, 0=on
             }
         }
-        Encoder_MainFunction();
+#endif
+#endif
+
+    }
+    else
+    {
+        // AD Wandlung
+        ADCDriverEven(TimerState & 0x02);
     }
 
 
@@ -778,8 +2052,14 @@ ISR(TIMER2_COMPA_vect)
         TimerState = 0;
     }
 
+    Timer_Profile(PROF_SLOT0 + ((TimerState - 1) & 0x03), (uint16_t)(TCNT1 - ProfStart));    // the slot just done
+
     // Interrupts sperren
     cli();
+    if (!EncoderRunning)            // else the interrupted encoder call enables Timer0 itself
+    {
+        TIMER0_IMSK |= (1<<TIMER0_IE);
+    }
 #if defined(__AVR_ATmega32__)
     TIMSK |= (1<<OCF2);
 #elif defined(__AVR_ATmega324P__) || defined(__AVR_ATmega644__) || defined(__AVR_ATmega644P__) || defined(__AVR_ATmega1284P__)
@@ -796,11 +2076,8 @@ void Timer_StartTimers(void)
     sreg = SREG;
     cli();
 
-    TimerFlags.Timer4msOV = 0;
-    TimerFlags.Timer10msOV = 0;
-    TimerFlags.Timer50msOV = 0;
-    TimerFlags.Timer100msOV = 0;
-    TimerFlags.TimersActive = 1;
+    TimerPending = 0;
+    TimersActive = 1;
 
     TimeBase4ms = 0;
     TimeBase10ms = 0;
@@ -809,75 +2086,263 @@ void Timer_StartTimers(void)
     SREG = sreg;
 }
 
-uint8_t Timer_TestAndResetTimerOV(uint8_t TimerId)
+// index of the job of the period TimerId, TIMER_JOBS for an unknown period
+static uint8_t Timer_Job(uint8_t TimerId)
 {
-    uint8_t result = 0;
-    uint8_t sreg;
-
     switch(TimerId)
     {
         case TIMER_4MS:
-            sreg = SREG;
-            cli();
-            if (TimerFlags.Timer4msOV)
-            {
-                TimerFlags.Timer4msOV = 0;
-                result = 1;
-            }
-            SREG = sreg;
-            break;
+            return TIMER_JOB_4MS;
 
         case TIMER_10MS:
-            sreg = SREG;
-            cli();
-            if (TimerFlags.Timer10msOV)
-            {
-                TimerFlags.Timer10msOV = 0;
-                result = 1;
-            }
-            SREG = sreg;
-            break;
+            return TIMER_JOB_10MS;
 
         case TIMER_50MS:
-            sreg = SREG;
-            cli();
-            if (TimerFlags.Timer50msOV)
-            {
-                TimerFlags.Timer50msOV = 0;
-                result = 1;
-            }
-            SREG = sreg;
-            break;
+            return TIMER_JOB_50MS;
 
         case TIMER_100MS:
-            sreg = SREG;
-            cli();
-            if (TimerFlags.Timer100msOV)
-            {
-                TimerFlags.Timer100msOV = 0;
-                result = 1;
-            }
-            SREG = sreg;
-            break;
+            return TIMER_JOB_100MS;
+
+        default:
+            return TIMER_JOBS;
     }
-    return result;
 }
 
+// job of the period TimerId waiting for Deadline (100us ticks) or longer since its period elapsed?
+// Does not start the job.
+uint8_t Timer_TestDeadline(uint8_t TimerId, uint16_t Deadline)
+{
+    uint8_t Job;
+    uint16_t Ready;
+    uint8_t sreg;
+
+    Job = Timer_Job(TimerId);
+    if (Job >= TIMER_JOBS)
+    {
+        return 0;
+    }
+
+    sreg = SREG;
+    cli();
+    if (!(TimerPending & (1<<Job)))
+    {
+        SREG = sreg;
+        return 0;
+    }
+    Ready = TimerReady[Job];
+    SREG = sreg;
+
+    return (uint16_t)((uint16_t)Timer_GetTicker() - Ready) >= Deadline;
+}
+
+// job of the period TimerId to start? Records the latency of the start.
+uint8_t Timer_TestAndResetTimerOV(uint8_t TimerId)
+{
+    uint8_t Job;
+    uint16_t Ready;
+    int16_t Latency;
+    uint8_t sreg;
+
+    Job = Timer_Job(TimerId);
+    if (Job >= TIMER_JOBS)
+    {
+        return 0;
+    }
+
+    sreg = SREG;
+    cli();
+    if (!(TimerPending & (1<<Job)))
+    {
+        SREG = sreg;
+        return 0;
+    }
+    TimerPending &= ~(1<<Job);
+    Ready = TimerReady[Job];
+    SREG = sreg;
+
+    Latency = (uint16_t)Timer_GetTicker() - Ready;
+    if (Latency > SchedLatencyMax[Job])
+    {
+        SchedLatencyMax[Job] = Latency;
+    }
+    return 1;
+}
+
+// ticks of 100us, 5 per Timer2 slot, the counter gives the ticks within the slot
 uint32_t Timer_GetTicker(void)
 {
     uint32_t result;
+    uint8_t count;
+    uint8_t sreg;
+
+    sreg = SREG;
+    cli();
+
+    result = Timer2Slots;
+#if defined(__AVR_ATmega32__)
+    count = TCNT2;
+    if (TIFR & (1<<OCF2))       // the slot is over, but its interrupt has not been taken yet
+    {
+        count = TCNT2;
+        result++;
+    }
+    count = ((uint16_t)count * 5) / (OCR2 + 1);
+#else
+    count = TCNT2;
+    if (TIFR2 & (1<<OCF2A))     // the slot is over, but its interrupt has not been taken yet
+    {
+        count = TCNT2;
+        result++;
+    }
+    count = ((uint16_t)count * 5) / (OCR2A + 1);
+#endif
+
+    SREG = sreg;
+
+    return result * 5 + count;
+}
+
+// cycles of one call of the fitted DAC driver, counted by Timer1
+// the driver shifts the last value once more, so the output does not change
+uint16_t Timer_BenchDAC(void)
+{
+    uint16_t start, empty, result;
+    uint8_t sreg;
+
+    sreg = SREG;
+    cli();
+
+    start = TCNT1;
+    empty = TCNT1 - start;          // the reading itself
+
+    start = TCNT1;
+#ifdef DUAL_DAC
+    DACDriver(DACLastOut, 0);
+#else
+    DACDriver(DACLastOut);
+#endif
+    result = TCNT1 - start - empty;
+
+    SREG = sreg;
+
+    return result;
+}
+
+// share of the CPU time taken by the interrupts in 1/1000, measured over a busy loop of 262144 cycles
+uint16_t Timer_BenchLoad(void)
+{
+    uint32_t start, result;
+
+    start = Timer_Cycles();
+    _delay_loop_2(0);               // 65536 * 4 cycles
+    result = Timer_Cycles() - start;
+
+    if (result <= 262144UL)
+    {
+        return 0;
+    }
+    return ((result - 262144UL) * 1000) / result;
+}
+
+// CPU cycles, Timer1 runs free at F_CPU, its overflow interrupt counts the upper word
+uint32_t Timer_Cycles(void)
+{
+    uint16_t High, Low;
     uint8_t sreg;
 
     sreg = SREG;
     cli();
 
-    result = Ticker;
+    High = Timer1Ovf;
+    Low = TCNT1;
+#if defined(__AVR_ATmega32__)
+    if ((TIFR & (1<<TOV1)) && (Low < 0x8000))
+#else
+    if ((TIFR1 & (1<<TOV1)) && (Low < 0x8000))
+#endif
+    {
+        High++;                     // overflow, but its interrupt has not been taken yet
+    }
+
+    SREG = sreg;
+
+    return ((uint32_t)High << 16) | Low;
+}
+
+//*** Profiling of the interrupts and jobs in CPU cycles ***
+#ifdef PROFILING
+PROFILE Profiles[PROF_COUNT];
 
+// budget of a run in cycles: a Timer2 slot for the interrupts, the period for the jobs
+const uint32_t ProfBudget[PROF_COUNT] PROGMEM =
+{
+    F_CPU / 2000, F_CPU / 2000, F_CPU / 2000, F_CPU / 2000,     // PROF_SLOT0..3
+    F_CPU / 2000,                   // PROF_COMPB
+    F_CPU / 2000,                   // PROF_ENCODER
+    F_CPU / 20,                     // PROF_PANEL, 50ms
+    F_CPU / 250,                    // PROF_PARSE, 4ms
+    F_CPU / 250,                    // PROF_GETVALUES, 4ms
+    F_CPU / 250,                    // PROF_SETLEVELDAC, delays the 4ms jobs
+    F_CPU / 8000,                   // PROF_WAVETICK, shortest tick
+};
+#endif
+
+// What: PROF_MIN, PROF_MAX, PROF_MEAN, PROF_RUNS, PROF_OVERRUNS
+int32_t Timer_ProfileGet(uint8_t Id, uint8_t What)
+{
+    int32_t result = 0;
+#ifdef PROFILING
+    PROFILE p;
+    uint8_t sreg;
+
+    if (Id >= PROF_COUNT)
+    {
+        return 0;
+    }
+
+    sreg = SREG;
+    cli();
+    p = Profiles[Id];
     SREG = sreg;
 
+    switch (What)
+    {
+        case PROF_MIN:
+            result = p.Min;
+            break;
+
+        case PROF_MAX:
+            result = p.Max;
+            break;
+
+        case PROF_MEAN:
+            result = p.Count ? p.Sum / p.Count : 0;
+            break;
+
+        case PROF_RUNS:
+            result = p.Count;
+            break;
+
+        case PROF_OVERRUNS:
+            result = p.Overruns;
+            break;
+    }
+#endif
     return result;
 }
 
+void Timer_ProfileReset(void)
+{
+#ifdef PROFILING
+    uint8_t sreg;
+
+    sreg = SREG;
+    cli();
+    memset(Profiles, 0, sizeof(Profiles));
+    SREG = sreg;
+#endif
+}
+
 void Timer_Wait_us(uint32_t us)
 {
     uint32_t start, stop, current;
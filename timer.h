@@ -22,16 +22,206 @@
 #define __TIMER_H__
 
 #include <inttypes.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
 
 #define TIMER_4MS       4
 #define TIMER_10MS      10
 #define TIMER_50MS      50
 #define TIMER_100MS     100
 
+#define TIMER_JOBS      4           // periods above, in this order in the statistics
+
+extern int16_t SchedLatencyMax[TIMER_JOBS];
+extern int16_t SchedOverruns[TIMER_JOBS];
+
+#if (RAMEND >= 0x1000)
+#define PROFILING                   // Timer_Profile records, not enough RAM with 2 KB
+#endif
+
+// profiled interrupts and jobs, Timer_Profile
+// The figures are wall time from PROF_START to Timer_Profile. They include the interrupts nesting
+// into the run: the Timer2 slots enable the interrupts, so a slot includes its sub-states (COMPB),
+// the waveform ticks and the UART, and a job includes all interrupts.
+#define PROF_SLOT0          0       // Timer2 slots, TimerState 0..3
+#define PROF_SLOT1          1
+#define PROF_SLOT2          2
+#define PROF_SLOT3          3
+#define PROF_COMPB          4       // Timer2 sub-states
+#define PROF_ENCODER        5       // Timer0, Encoder_MainFunction
+#define PROF_PANEL          6       // jobPanel
+#define PROF_PARSE          7       // jobParseData
+#define PROF_GETVALUES      8       // jobGetValues
+#define PROF_SETLEVELDAC    9       // SetLevelDAC
+#define PROF_WAVETICK       10      // Timer1 compare A, waveform tick
+#define PROF_COUNT          11
+
+// Timer_ProfileGet
+#define PROF_MIN            0
+#define PROF_MAX            1
+#define PROF_MEAN           2
+#define PROF_RUNS           3
+#define PROF_OVERRUNS       4
+
+extern uint8_t ProfSelect;
+
+#if (RAMEND >= 0x1000)
+#define CAPTURE                     // capture buffer of the ADC values, not enough RAM with 2 KB
+#if (RAMEND >= 0x4000)
+#define CAPTURESIZE         1024    // samples of U and I, power of 2
+#else
+#define CAPTURESIZE         64
+#endif
+#endif
+
+// Timer_CaptureControl
+#define CAPTURE_CMD_STOP    0
+#define CAPTURE_CMD_ARM     1
+#define CAPTURE_CMD_TRIGGER 2       // trigger now, whatever the source
+
+// Timer_CaptureState
+#define CAPTURE_IDLE        0
+#define CAPTURE_ARMED       1       // filling the samples before the trigger, waiting for it
+#define CAPTURE_TRIGGERED   2       // taking the samples after the trigger
+#define CAPTURE_DONE        3       // record complete, Timer_CaptureRead
+
+// trigger sources, CaptureSource
+#define CAPTURE_SRC_MANUAL  0       // CAPTURE_CMD_TRIGGER only
+#define CAPTURE_SRC_ARB     1       // start of the arbitrary sequence (table)
+#define CAPTURE_SRC_RIPPLE  2       // edge of the ripple
+#define CAPTURE_SRC_U_RISE  3       // U rises to CaptureRawLow
+#define CAPTURE_SRC_U_FALL  4       // U falls to CaptureRawLow
+#define CAPTURE_SRC_U_WIN   5       // U leaves CaptureRawLow..CaptureRawHigh
+#define CAPTURE_SRC_I_RISE  6       // the same for I
+#define CAPTURE_SRC_I_FALL  7
+#define CAPTURE_SRC_I_WIN   8
+#define CAPTURE_SRC_RELAY   9       // switch of the input relays, jobSwitchRelay
+#define CAPTURE_SRC_MAX     CAPTURE_SRC_RELAY
+
+// trigger events, Timer_CaptureEvent
+#define CAPTURE_EV_MANUAL   0x01
+#define CAPTURE_EV_ARB      0x02
+#define CAPTURE_EV_RIPPLE   0x04
+#define CAPTURE_EV_LEVEL    0x08    // threshold or window of the source
+#define CAPTURE_EV_RELAY    0x10
+
+extern int16_t CapturePre;
+extern int16_t CapturePost;
+extern uint8_t CaptureDecimation;
+extern uint8_t CaptureSource;
+extern uint16_t CaptureRawLow;
+extern uint16_t CaptureRawHigh;
+
+#if (RAMEND >= 0x1000)
+#define STATISTICS                  // statistics of U, I and P in the ISR, not enough RAM with 2 KB
+#endif
+
+// channels of STATS
+#define STAT_U              0
+#define STAT_I              1
+#define STAT_P              2       // U * I of the same sample
+#define STAT_CHANNELS       3
+
+// values of a channel, GetStat
+#define STAT_MIN            0
+#define STAT_MAX            1
+#define STAT_MEAN           2
+#define STAT_RMS            3
+#define STAT_VALUES         4
+
+// StatSnapshot
+#define STAT_CMD_RESTART    0       // drop the statistics, start again
+#define STAT_CMD_SNAP       1       // snapshot of the last window
+#define STAT_CMD_SNAPRESTART 2      // snapshot and start again at the same time
+
+#define STAT_WINDOWMAX      30000   // samples, 60s
+#define STAT_SETTLE         20      // values of U skipped after a range switch, 40ms
+
+// statistics of a channel, raw ADC values + offset, of U and I multiplied for P
+typedef struct
+{
+    uint32_t Min;
+    uint32_t Max;
+    uint64_t Sum;
+    uint64_t Sum2;                  // sum of the squares, of P >> 16 for P
+} STATACC;
+
+typedef struct
+{
+    uint32_t Count;                 // samples, a value of U with the last one of I every 2ms
+    STATACC  Ch[STAT_CHANNELS];
+} STATS;
+
+extern int16_t StatWindow;
+
 uint8_t  Timer_TestAndResetTimerOV(uint8_t TimerId);
+uint8_t  Timer_TestDeadline(uint8_t TimerId, uint16_t Deadline);
 void	 Timer_Init(void);
 uint32_t Timer_GetTicker(void);
 void	 Timer_Wait_us(uint32_t);
 void     Timer_StartTimers(void);
+uint16_t Timer_BenchDAC(void);
+uint16_t Timer_BenchLoad(void);
+uint32_t Timer_Cycles(void);
+int32_t  Timer_ProfileGet(uint8_t Id, uint8_t What);
+void     Timer_ProfileReset(void);
+void     Timer_SelectHandlers(void);
+void     Timer_CaptureControl(uint8_t Cmd);
+void     Timer_CaptureEvent(uint8_t Event);
+uint8_t  Timer_CaptureState(void);
+uint32_t Timer_CaptureTime(void);
+int16_t  Timer_CaptureCount(void);
+int16_t  Timer_CaptureTrigger(void);
+uint8_t  Timer_CaptureRead(uint16_t Index, uint16_t* pU, uint16_t* pI);
+void     Timer_StatRestart(int16_t OffsetU, int16_t OffsetI, uint8_t Skip);
+uint8_t  Timer_StatRead(STATS* pStats, uint8_t Restart);
+
+//*** Profiling in CPU cycles ***
+// PROF_START(Type, Now) declares ProfStart, Timer_Profile records the run of Id. Without PROFILING
+// both compile to nothing, so the interrupts do not read the clock or call anything for it.
+#ifdef PROFILING
+typedef struct
+{
+    uint32_t Min;
+    uint32_t Max;
+    uint32_t Sum;                   // of Count runs, both are halved before the sum overflows
+    uint16_t Count;
+    uint16_t Overruns;              // runs longer than the budget
+} PROFILE;
+
+extern PROFILE Profiles[PROF_COUNT];
+extern const uint32_t ProfBudget[PROF_COUNT] PROGMEM;
+
+#define PROF_START(Type, Now)   Type ProfStart = (Now)
+
+// called by the interrupt or job Id only, so no locking
+static inline void Timer_Profile(uint8_t Id, uint32_t Cycles)
+{
+    PROFILE* p = &Profiles[Id];
+
+    if ((p->Count == 0) || (Cycles < p->Min))
+    {
+        p->Min = Cycles;
+    }
+    if (Cycles > p->Max)
+    {
+        p->Max = Cycles;
+    }
+    if ((p->Count == 0xffff) || (p->Sum + Cycles < p->Sum))
+    {
+        p->Sum >>= 1;
+        p->Count >>= 1;
+    }
+    p->Sum += Cycles;
+    p->Count++;
+    if ((Cycles > pgm_read_dword(&ProfBudget[Id])) && (p->Overruns < 0xffff))
+    {
+        p->Overruns++;
+    }
+}
+#else
+#define PROF_START(Type, Now)
+#define Timer_Profile(Id, Cycles)
+#endif
 
 #endif